@@ -0,0 +1,80 @@
+#ifndef BYTES_H
+#define BYTES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Binary forms the server keeps on its own disk: hibernated sessions and the
+// journal. Values are written in host byte order, since the files never leave
+// the machine that wrote them.
+
+// Appends values to a string
+class ByteWriter {
+private:
+    std::string& out;
+
+public:
+    explicit ByteWriter(std::string& out) : out(out) {}
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Up to 64 KiB, with a 16-bit length; longer text is cut at the last whole
+    // UTF-8 character that fits, so it still reads back as valid text
+    void put_text(std::string_view text) {
+        if (text.size() > UINT16_MAX) {
+            std::size_t size = UINT16_MAX;
+            while (size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) size--;
+            text = text.substr(0, size);
+        }
+        put(static_cast<std::uint16_t>(text.size()));
+        out.append(text);
+    }
+
+    // Any size, with a 32-bit length
+    void put_blob(std::string_view blob) {
+        put(static_cast<std::uint32_t>(blob.size()));
+        out.append(blob);
+    }
+};
+
+// Reads values back; running past the end throws std::invalid_argument with the given message
+class ByteReader {
+private:
+    std::string_view bytes;
+    std::size_t position;
+    const char* error;
+
+public:
+    ByteReader(std::string_view bytes, const char* error) : bytes(bytes), position(0), error(error) {}
+
+    std::string_view take(std::size_t size) {
+        if (bytes.size() - position < size) throw std::invalid_argument(error);
+        std::string_view result = bytes.substr(position, size);
+        position += size;
+        return result;
+    }
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T result;
+        std::memcpy(&result, take(sizeof(result)).data(), sizeof(result));
+        return result;
+    }
+
+    std::string text() { return std::string(take(get<std::uint16_t>())); }
+    std::string_view blob() { return take(get<std::uint32_t>()); }
+
+    bool at_end() const { return position == bytes.size(); }
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "Connection.h"
+
+// Constructor
+Connection::Connection(int fd, std::shared_ptr<WorldHost> host, SessionArchive* archive, Journal* journal,
+                       Scheduler* scheduler, Session::Notify notify)
+    : fd(fd), archive(archive), last_active(std::chrono::steady_clock::now()), scheduled(scheduler != nullptr),
+      input_offset(0), output_offset(0), input_closed(false), close_posted(false) {
+    session = std::make_shared<Session>(std::move(host), journal, output);
+    if (scheduler) session->attach(*scheduler, std::move(notify));
+}
+
+Connection::~Connection() {
+    if (scheduled) session->disconnect();
+}
+
+int Connection::get_fd() const { return fd; }
+const Session* Connection::get_session() const { return session.get(); }
+
+// Input
+bool Connection::receive(const char* data, std::size_t size) {
+    last_active = std::chrono::steady_clock::now();
+    input.append(data, size);
+    return input.size() - input_offset <= MAX_LINE || input.find('\n', input_offset) != std::string::npos;
+}
+
+void Connection::end_of_input() { input_closed = true; }
+
+/**
+ * @brief Feeds complete lines to the session.
+ *
+ * Stops early once the unsent output passes the high watermark, leaving the
+ * remaining lines buffered; the backend stops reading until the client catches
+ * up, so a client that never reads cannot make the server buffer without bound.
+ * A hibernating session is woken once there is a line (or end of input) for it.
+ *
+ * @return True if complete lines are still buffered; call again once output drains.
+ */
+bool Connection::process() {
+    if (session->is_hibernating()) {
+        if (!input_closed && input.find('\n', input_offset) == std::string::npos) return false;
+        session->wake(*archive, output);
+    }
+    if (scheduled) return post_lines();
+    while (!session->done() && output.size() - output_offset < HIGH_WATERMARK) {
+        std::size_t end = input.find('\n', input_offset);
+        if (end == std::string::npos) break;
+        std::string_view line(input.data() + input_offset, end - input_offset);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        session->execute(line, output);
+        input_offset = end + 1;
+    }
+    compact_input();
+    bool more = !session->done() && input.find('\n', input_offset) != std::string::npos;
+    if (input_closed && !session->done() && !more) session->close(output);
+    session->log_state();
+    return more;
+}
+
+/**
+ * @brief Collects a scheduled Session's replies and posts it the lines that fit.
+ *
+ * Lines stay buffered here while the Session's inbox is full or the output is
+ * over the high watermark; the Session's next notification brings the backend
+ * back to post them. End of input is passed on after the last line.
+ *
+ * @return True if lines are held back by the output backlog alone; call again once output drains.
+ */
+bool Connection::post_lines() {
+    session->drain(output);
+    bool held = false;
+    while (!session->is_over()) {
+        std::size_t end = input.find('\n', input_offset);
+        if (end == std::string::npos) break;
+        if (output.size() - output_offset >= HIGH_WATERMARK) {
+            held = true;
+            break;
+        }
+        std::string_view line(input.data() + input_offset, end - input_offset);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!session->post(std::string(line))) break;
+        input_offset = end + 1;
+    }
+    compact_input();
+    if (input_closed && !close_posted && input.find('\n', input_offset) == std::string::npos) {
+        session->close_input();
+        close_posted = true;
+    }
+    return held;
+}
+
+void Connection::compact_input() {
+    if (input_offset == input.size()) {
+        input.clear();
+        input_offset = 0;
+    } else if (input_offset > MAX_LINE) {
+        input.erase(0, input_offset);
+        input_offset = 0;
+    }
+}
+
+// Output
+std::string_view Connection::pending_output() const {
+    return std::string_view(output).substr(output_offset);
+}
+
+void Connection::consume_output(std::size_t size) {
+    output_offset += size;
+    if (output_offset == output.size()) {
+        output.clear();
+        output_offset = 0;
+    }
+}
+
+// State
+// A scheduled Session's own state belongs to the worker running it
+bool Connection::done() const { return scheduled ? session->is_over() : session->done(); }
+
+bool Connection::wants_input() const {
+    return !input_closed && !done() && input.size() - input_offset < HIGH_WATERMARK &&
+           output.size() - output_offset < HIGH_WATERMARK;
+}
+
+bool Connection::finished() const {
+    return done() && (!scheduled || session->drained()) && output_offset == output.size();
+}
+
+// Hibernation
+bool Connection::hibernate(std::chrono::steady_clock::time_point idle_since) {
+    if (!archive || input_closed || last_active > idle_since || input_offset != input.size() ||
+        output_offset != output.size() || !session->hibernate(*archive)) {
+        return false;
+    }
+    input = std::string();
+    output = std::string();
+    return true;
+}
+
+bool Connection::is_hibernating() const { return session->is_hibernating(); }
+
+// Ready connections
+ReadyList::ReadyList(std::function<void()> wake) : wake(std::move(wake)) {}
+
+Session::Notify ReadyList::notifier(int fd) {
+    return [this, fd](std::shared_ptr<Session> session) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            was_empty = ready.empty();
+            ready.emplace_back(fd, std::move(session));
+        }
+        if (was_empty) wake();
+    };
+}
+
+ReadyList::Entries ReadyList::take() {
+    Entries taken;
+    std::lock_guard<std::mutex> lock(mutex);
+    taken.swap(ready);
+    return taken;
+}
@@ -0,0 +1,115 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Journal.h"
+#include "Session.h"
+#include "SessionArchive.h"
+
+// One network client's Session, independent of how bytes reach it. Server
+// backends feed received bytes in and write pending output out; the Connection
+// splits the input into lines for the Session and buffers its replies. An idle
+// session can hibernate: its Game goes to a SessionArchive and comes back with
+// the next line, so only active players hold a Game in memory. Given a
+// Scheduler, the Session runs on its workers instead of the backend's thread,
+// and the backend hears through its ReadyList when replies are waiting.
+class Connection {
+public:
+    static constexpr std::size_t MAX_LINE = 4096;
+    static constexpr std::size_t HIGH_WATERMARK = 64 * 1024;
+
+private:
+    int fd;
+    std::shared_ptr<Session> session;
+    SessionArchive* archive;
+    std::chrono::steady_clock::time_point last_active;
+    bool scheduled;       // the Session runs on a Scheduler
+    std::string input;
+    std::size_t input_offset;
+    std::string output;
+    std::size_t output_offset;
+    bool input_closed;
+    bool close_posted;    // a scheduled Session has been told input ended
+
+    // Helper methods
+    bool done() const;
+    bool post_lines();
+    void compact_input();
+
+public:
+    // Constructor; queues the welcome text and first prompt. Without an archive the session
+    // never hibernates, and without a journal it does not outlive the connection
+    Connection(int fd, std::shared_ptr<WorldHost> host, SessionArchive* archive = nullptr, Journal* journal = nullptr,
+               Scheduler* scheduler = nullptr, Session::Notify notify = {});
+
+    // Lines a scheduled Session has not run yet are dropped with it
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    int get_fd() const;
+
+    // The Session played over this connection, for matching a ReadyList entry to it
+    const Session* get_session() const;
+
+    // Buffers received bytes; false if a line exceeds MAX_LINE and the client should be dropped
+    bool receive(const char* data, std::size_t size);
+
+    // The client closed its side; no more lines will arrive
+    void end_of_input();
+
+    // Runs complete buffered lines until the output passes HIGH_WATERMARK; true if lines are left over.
+    // A scheduled Session is handed the lines instead and its queued replies are collected; lines
+    // waiting for room in its inbox do not count, since the ReadyList says when to call again
+    bool process();
+
+    // Output not yet written to the socket, and how much of it was written
+    std::string_view pending_output() const;
+    void consume_output(std::size_t size);
+
+    // False while the input or output backlog is over HIGH_WATERMARK or the game is over
+    bool wants_input() const;
+
+    // True once the game is over (including by end of input) and all output has been written
+    bool finished() const;
+
+    // Saves the session to the archive if nothing has been received since `idle_since`
+    // and no input or output is buffered; true if it is now hibernating
+    bool hibernate(std::chrono::steady_clock::time_point idle_since);
+    bool is_hibernating() const;
+};
+
+// Connections whose scheduled Sessions have replies waiting, handed from the
+// workers to the backend that owns the connections. The backend is woken only
+// when the list stops being empty, so a burst of replies costs one wakeup.
+class ReadyList {
+public:
+    using Entries = std::vector<std::pair<int, std::shared_ptr<Session>>>;
+
+private:
+    std::mutex mutex;
+    Entries ready;
+    std::function<void()> wake;
+
+public:
+    // Constructor; `wake` must be safe to call from any thread
+    explicit ReadyList(std::function<void()> wake);
+
+    // The Notify for the Session on connection `fd`
+    Session::Notify notifier(int fd);
+
+    // Everything reported since the last call; the backend checks each Session is
+    // still the one on its connection, since the descriptor may have been reused
+    Entries take();
+};
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file Console.cpp
+ * @brief Console front end for GVZork.
+ *
+ * The Console owns one Game session and is the only place that reads from
+ * std::cin and writes to std::cout. All game logic lives in the gvzork library.
+ */
+
+#include "Console.h"
+#include <iostream>
+
+// Constructor
+Console::Console(std::shared_ptr<World> world) : game(std::move(world)) {}
+
+/**
+ * @brief The core game loop.
+ *
+ * This method prints the prompt, reads one line of input at a time, and hands
+ * it to the Game until the game ends or input runs out. Output is flushed once
+ * per line, when std::cin (tied to std::cout) reads the next one.
+ */
+void Console::play() {
+    std::cout << game.welcome();
+
+    while (game.is_in_progress()) {
+        std::cout << game.prompt();
+        std::string input;
+        if (!std::getline(std::cin, input)) break;
+        std::cout << game.execute(input);
+    }
+
+    // End game message
+    std::cout << game.outcome();
+}
@@ -0,0 +1,19 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "Game.h"
+
+// Thin stdin/stdout front end over a Game session
+class Console {
+private:
+    Game game;
+
+public:
+    // Constructor; plays in a World of its own unless given one
+    explicit Console(std::shared_ptr<World> world = std::make_shared<World>());
+
+    // Core game loop
+    void play();
+};
+
+#endif
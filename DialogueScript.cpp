@@ -0,0 +1,234 @@
+#include "DialogueScript.h"
+#include <charconv>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    std::size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) return {};
+    std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+std::invalid_argument script_error(int line, const std::string& message) {
+    return std::invalid_argument("Dialogue line " + std::to_string(line) + ": " + message);
+}
+
+}
+
+/**
+ * @brief Compiles dialogue source text into bytecode.
+ *
+ * Compilation happens once, when the World is built; labels are resolved and
+ * strings interned here so that running a script only walks an array. What
+ * the script says stays plain until its template packs it.
+ *
+ * @param source The script text.
+ * @return The compiled script.
+ */
+DialogueScript DialogueScript::compile(std::string_view source) {
+    static const std::map<std::string_view, Op> mnemonics = {
+        {"push", Op::PUSH}, {"load", Op::LOAD}, {"store", Op::STORE}, {"dup", Op::DUP}, {"pop", Op::POP},
+        {"add", Op::ADD}, {"sub", Op::SUB}, {"eq", Op::EQ}, {"lt", Op::LT}, {"gt", Op::GT}, {"not", Op::NOT},
+        {"has", Op::HAS}, {"calories", Op::CALORIES}, {"jmp", Op::JMP}, {"jz", Op::JZ}, {"say", Op::SAY},
+        {"saynum", Op::SAYNUM}, {"end", Op::END}};
+
+    DialogueScript script;
+    std::map<std::string, std::int32_t, std::less<>> labels;
+    std::vector<std::pair<std::size_t, std::pair<std::string, int>>> fixups;
+
+    int line_number = 0;
+    std::size_t pos = 0;
+    while (pos <= source.size()) {
+        std::size_t end = source.find('\n', pos);
+        if (end == std::string_view::npos) end = source.size();
+        std::string_view line = source.substr(pos, end - pos);
+        pos = end + 1;
+        line_number++;
+
+        // Strip comments, but not a '#' inside quotes
+        bool quoted = false;
+        for (std::size_t i = 0; i < line.size(); i++) {
+            if (line[i] == '"' && (i == 0 || line[i - 1] != '\\')) quoted = !quoted;
+            if (line[i] == '#' && !quoted) {
+                line = line.substr(0, i);
+                break;
+            }
+        }
+        line = trim(line);
+        if (line.empty()) continue;
+
+        if (line.back() == ':') {
+            std::string label(trim(line.substr(0, line.size() - 1)));
+            if (label.empty() || !labels.emplace(label, static_cast<std::int32_t>(script.code.size())).second) {
+                throw script_error(line_number, "bad or duplicate label.");
+            }
+            continue;
+        }
+
+        std::size_t split = line.find_first_of(" \t");
+        std::string_view mnemonic = line.substr(0, split);
+        std::string_view operand = split == std::string_view::npos ? std::string_view{} : trim(line.substr(split));
+        auto found = mnemonics.find(mnemonic);
+        if (found == mnemonics.end()) throw script_error(line_number, "unknown instruction '" + std::string(mnemonic) + "'.");
+
+        Instruction instruction{found->second, 0};
+        switch (instruction.op) {
+            case Op::PUSH:
+            case Op::LOAD:
+            case Op::STORE: {
+                auto [ptr, ec] = std::from_chars(operand.data(), operand.data() + operand.size(), instruction.arg);
+                if (operand.empty() || ec != std::errc() || ptr != operand.data() + operand.size()) {
+                    throw script_error(line_number, "expected a number.");
+                }
+                if (instruction.op != Op::PUSH && (instruction.arg < 0 || instruction.arg >= static_cast<std::int32_t>(VARS))) {
+                    throw script_error(line_number, "no such variable.");
+                }
+                break;
+            }
+            case Op::HAS:
+                if (operand.empty()) throw script_error(line_number, "expected an Item name.");
+                instruction.arg = static_cast<std::int32_t>(script.names.size());
+                script.names.emplace_back(operand);
+                break;
+            case Op::SAY: {
+                if (operand.size() < 2 || operand.front() != '"' || operand.back() != '"') {
+                    throw script_error(line_number, "expected quoted text.");
+                }
+                std::string text;
+                for (std::size_t i = 1; i + 1 < operand.size(); i++) {
+                    char c = operand[i];
+                    if (c == '\\' && i + 2 < operand.size()) {
+                        c = operand[++i];
+                        if (c == 'n') c = '\n';
+                    }
+                    text += c;
+                }
+                instruction.arg = static_cast<std::int32_t>(script.texts.size());
+                script.texts.emplace_back(std::move(text));
+                break;
+            }
+            case Op::JMP:
+            case Op::JZ:
+                if (operand.empty()) throw script_error(line_number, "expected a label.");
+                fixups.push_back({script.code.size(), {std::string(operand), line_number}});
+                break;
+            default:
+                if (!operand.empty()) throw script_error(line_number, "unexpected operand.");
+                break;
+        }
+        script.code.push_back(instruction);
+    }
+
+    for (const auto& [index, target] : fixups) {
+        auto label = labels.find(target.first);
+        if (label == labels.end()) throw script_error(target.second, "undefined label '" + target.first + "'.");
+        script.code[index].arg = label->second;
+    }
+    // Falling off the end stops the script
+    script.code.push_back({Op::END, 0});
+    return script;
+}
+
+/**
+ * @brief Interprets the script against one player's context.
+ *
+ * The operand stack is a fixed array on the C++ stack and state variables live
+ * in the NPC, so a step never allocates. Stack faults and runaway loops (more
+ * than MAX_STEPS instructions) stop the script.
+ *
+ * @param context The player and NPC state the script reads and writes.
+ * @param out Where the NPC's words are appended.
+ * @return False if the script faulted.
+ */
+bool DialogueScript::run(DialogueContext& context, std::string& out) const {
+    std::array<std::int32_t, STACK> stack;
+    std::size_t top = 0;
+    std::size_t pc = 0;
+
+    for (int steps = 0; steps < MAX_STEPS; steps++) {
+        const Instruction& instruction = code[pc++];
+        // Checked up front: how many values the instruction pops, and pushes net of that
+        switch (instruction.op) {
+            case Op::PUSH:
+            case Op::LOAD:
+            case Op::HAS:
+            case Op::CALORIES:
+                if (top == STACK) return false;
+                break;
+            case Op::DUP:
+                if (top == 0 || top == STACK) return false;
+                break;
+            case Op::STORE:
+            case Op::POP:
+            case Op::NOT:
+            case Op::JZ:
+            case Op::SAYNUM:
+                if (top == 0) return false;
+                break;
+            case Op::ADD:
+            case Op::SUB:
+            case Op::EQ:
+            case Op::LT:
+            case Op::GT:
+                if (top < 2) return false;
+                break;
+            default:
+                break;
+        }
+
+        switch (instruction.op) {
+            case Op::PUSH: stack[top++] = instruction.arg; break;
+            case Op::LOAD: stack[top++] = context.vars[instruction.arg]; break;
+            case Op::STORE: context.vars[instruction.arg] = stack[--top]; break;
+            case Op::DUP: stack[top] = stack[top - 1]; top++; break;
+            case Op::POP: top--; break;
+            case Op::ADD: top--; stack[top - 1] = static_cast<std::int32_t>(static_cast<std::uint32_t>(stack[top - 1]) + static_cast<std::uint32_t>(stack[top])); break;
+            case Op::SUB: top--; stack[top - 1] = static_cast<std::int32_t>(static_cast<std::uint32_t>(stack[top - 1]) - static_cast<std::uint32_t>(stack[top])); break;
+            case Op::EQ: top--; stack[top - 1] = stack[top - 1] == stack[top]; break;
+            case Op::LT: top--; stack[top - 1] = stack[top - 1] < stack[top]; break;
+            case Op::GT: top--; stack[top - 1] = stack[top - 1] > stack[top]; break;
+            case Op::NOT: stack[top - 1] = !stack[top - 1]; break;
+            case Op::HAS: {
+                const std::string& wanted = names[static_cast<std::size_t>(instruction.arg)];
+                std::int32_t carried = 0;
+                for (const auto& item : *context.inventory) {
+                    if (item.name == wanted) {
+                        carried = 1;
+                        break;
+                    }
+                }
+                stack[top++] = carried;
+                break;
+            }
+            case Op::CALORIES: stack[top++] = context.calories_needed; break;
+            case Op::JMP: pc = static_cast<std::size_t>(instruction.arg); break;
+            case Op::JZ:
+                if (stack[--top] == 0) pc = static_cast<std::size_t>(instruction.arg);
+                break;
+            case Op::SAY: texts[static_cast<std::size_t>(instruction.arg)].append_to(out); break;
+            case Op::SAYNUM: {
+                char digits[12];
+                auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), stack[--top]);
+                out.append(digits, end);
+                break;
+            }
+            case Op::END: return true;
+        }
+    }
+    return false;
+}
+
+// Text
+std::vector<std::string> DialogueScript::get_texts() const {
+    std::vector<std::string> result;
+    result.reserve(texts.size());
+    for (const auto& text : texts) result.push_back(text.str());
+    return result;
+}
+
+void DialogueScript::pack(const std::shared_ptr<const TextDictionary>& dictionary) {
+    for (auto& text : texts) text.pack(dictionary);
+}
@@ -0,0 +1,62 @@
+#ifndef DIALOGUESCRIPT_H
+#define DIALOGUESCRIPT_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Item.h"
+#include "PackedText.h"
+
+// What a script can see when it runs: the player's inventory, the Elf's goal, and
+// the speaking NPC's own state variables (which the script may change)
+struct DialogueContext {
+    const std::vector<Item>* inventory;
+    int calories_needed;
+    std::int32_t* vars;
+};
+
+// NPC dialogue compiled to bytecode for a small stack machine.
+//
+// Scripts are written one instruction per line; `label:` marks a jump target and
+// `#` starts a comment:
+//   push N | load V | store V | dup | pop     stack and state variables (V < VARS)
+//   add | sub | eq | lt | gt | not            arithmetic and tests on the top of stack
+//   has ITEM | calories                       push 1/0 for an Item carried, the calories still needed
+//   jmp LABEL | jz LABEL                      jump, or jump if the popped value is zero
+//   say "TEXT" | saynum | end                 append text, append the popped number, stop
+class DialogueScript {
+public:
+    static constexpr std::size_t VARS = 8;
+    static constexpr std::size_t STACK = 16;
+    static constexpr int MAX_STEPS = 1024;
+
+private:
+    enum class Op : std::uint8_t { PUSH, LOAD, STORE, DUP, POP, ADD, SUB, EQ, LT, GT, NOT, HAS, CALORIES, JMP, JZ, SAY, SAYNUM, END };
+
+    struct Instruction {
+        Op op;
+        std::int32_t arg;
+    };
+
+    std::vector<Instruction> code;
+    std::vector<std::string> names;    // Items tested by `has`
+    std::vector<PackedText> texts;     // what `say` appends
+
+public:
+    // Compiles source text; throws std::invalid_argument naming the bad line
+    static DialogueScript compile(std::string_view source);
+
+    // Runs the script, appending what the NPC says to `out`. Nothing is allocated
+    // beyond `out` growing and unpacking text this thread has not shown lately;
+    // returns false if the script faulted or ran too long
+    bool run(DialogueContext& context, std::string& out) const;
+
+    // Everything the script says, and packing it with a World's dictionary
+    std::vector<std::string> get_texts() const;
+    void pack(const std::shared_ptr<const TextDictionary>& dictionary);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "EntityStore.h"
+#include <mutex>
+
+// Row management
+std::uint32_t EntityStore::add(const Item& item, std::int32_t owner) {
+    std::string key = item.get_name() + '\0' + item.get_description();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto [kind, inserted] = kind_ids.try_emplace(std::move(key), static_cast<std::uint32_t>(names.size()));
+    if (inserted) {
+        names.push_back(item.get_name());
+        descriptions.push_back(item.description);
+    }
+
+    std::uint32_t row;
+    if (!free_rows.empty()) {
+        row = free_rows.back();
+        free_rows.pop_back();
+    } else {
+        row = static_cast<std::uint32_t>(owners.size());
+        kinds.push_back(0);
+        calories.push_back(0);
+        weights.push_back(0);
+        owners.push_back(NOWHERE);
+    }
+    kinds[row] = kind->second;
+    calories[row] = item.get_calories();
+    weights[row] = item.get_weight();
+    owners[row] = owner;
+    return row;
+}
+
+void EntityStore::remove(std::uint32_t row) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    owners[row] = NOWHERE;
+    calories[row] = 0;
+    weights[row] = 0;
+    free_rows.push_back(row);
+}
+
+// Row access
+Item EntityStore::get(std::uint32_t row) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return Item(names[kinds[row]], descriptions[kinds[row]], calories[row], weights[row]);
+}
+
+bool EntityStore::is_named(std::uint32_t row, std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names[kinds[row]] == name;
+}
+
+std::size_t EntityStore::rows() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return owners.size();
+}
+
+/**
+ * @brief Counts the Items lying in Locations.
+ *
+ * The aggregates below walk one or two contiguous columns with no branches
+ * (freed rows hold zero calories and weight), so they compile to vector loops.
+ *
+ * @return The number of Items not taken.
+ */
+std::size_t EntityStore::count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const std::int32_t* owner = owners.data();
+    std::size_t total = 0;
+    for (std::size_t row = 0; row < owners.size(); row++) total += owner[row] != NOWHERE;
+    return total;
+}
+
+long long EntityStore::total_calories() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const int* calorie = calories.data();
+    long long total = 0;
+    for (std::size_t row = 0; row < calories.size(); row++) total += calorie[row];
+    return total;
+}
+
+double EntityStore::total_weight() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const float* weight = weights.data();
+    double total = 0;
+    for (std::size_t row = 0; row < weights.size(); row++) total += weight[row];
+    return total;
+}
@@ -0,0 +1,68 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Item.h"
+
+// Structure-of-arrays storage for the Items lying in a World's Locations. Each
+// Item is a row across parallel columns (kind, calories, weight, owner); names
+// and descriptions are interned once per kind. Rows freed by taking an Item are
+// reused. Locations hold only row ids.
+//
+// Adding and removing rows takes the store's lock exclusively, reading takes it
+// shared; both may happen while a Location's lock is held, never the reverse.
+class EntityStore {
+public:
+    static constexpr std::int32_t NOWHERE = -1;
+
+private:
+    std::vector<std::uint32_t> kinds;
+    std::vector<int> calories;
+    std::vector<float> weights;
+    std::vector<std::int32_t> owners;
+
+    std::vector<std::string> names;
+    std::vector<PackedText> descriptions;
+    std::unordered_map<std::string, std::uint32_t> kind_ids;
+    std::vector<std::uint32_t> free_rows;
+    mutable std::shared_mutex mutex;
+
+public:
+    // Row management; `owner` is a Location id
+    std::uint32_t add(const Item& item, std::int32_t owner);
+    void remove(std::uint32_t row);
+
+    // Row access
+    Item get(std::uint32_t row) const;
+    bool is_named(std::uint32_t row, std::string_view name) const;
+    std::size_t rows() const;
+
+    // Calls `visit(name, calories, weight)` for each row, under one shared lock
+    template <typename Visit>
+    void for_rows(const std::vector<std::uint32_t>& rows, Visit&& visit) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (std::uint32_t row : rows) visit(std::string_view(names[kinds[row]]), calories[row], weights[row]);
+    }
+
+    // Calls `visit(row, owner, name, calories, weight)` for every Item in a Location
+    template <typename Visit>
+    void for_each(Visit&& visit) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (std::uint32_t row = 0; row < owners.size(); row++) {
+            if (owners[row] == NOWHERE) continue;
+            visit(row, owners[row], std::string_view(names[kinds[row]]), calories[row], weights[row]);
+        }
+    }
+
+    // World-wide aggregates over the Items lying in Locations
+    std::size_t count() const;
+    long long total_calories() const;
+    double total_weight() const;
+};
+
+#endif
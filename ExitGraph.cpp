@@ -0,0 +1,43 @@
+#include "ExitGraph.h"
+#include "Location.h"
+
+// Constructors
+ExitGraph::ExitGraph() : offsets(1, 0) {}
+
+ExitGraph::ExitGraph(const std::vector<Location>& locations) {
+    const Location* first = locations.data();
+    offsets.reserve(locations.size() + 1);
+    offsets.push_back(0);
+    for (const auto& location : locations) {
+        for (const auto& [direction, neighbor] : location.get_locations()) {
+            targets.push_back(static_cast<std::uint32_t>(neighbor - first));
+        }
+        offsets.push_back(static_cast<std::uint32_t>(targets.size()));
+    }
+}
+
+std::size_t ExitGraph::size() const { return offsets.size() - 1; }
+const std::uint32_t* ExitGraph::exits_begin(std::uint32_t location) const { return targets.data() + offsets[location]; }
+const std::uint32_t* ExitGraph::exits_end(std::uint32_t location) const { return targets.data() + offsets[location + 1]; }
+const std::vector<std::uint32_t>& ExitGraph::get_offsets() const { return offsets; }
+const std::vector<std::uint32_t>& ExitGraph::get_targets() const { return targets; }
+
+void ExitGraph::distances_from(std::uint32_t start, int max_moves, std::vector<std::uint32_t>& order,
+                               std::vector<int>& distances) const {
+    order.clear();
+    distances.assign(size(), -1);
+    if (start >= size()) return;
+    distances[start] = 0;
+    order.push_back(start);
+    // `order` doubles as the queue
+    for (std::size_t head = 0; head < order.size(); head++) {
+        std::uint32_t location = order[head];
+        int next = distances[location] + 1;
+        if (max_moves >= 0 && next > max_moves) break;
+        for (const std::uint32_t* exit = exits_begin(location); exit != exits_end(location); exit++) {
+            if (distances[*exit] >= 0) continue;
+            distances[*exit] = next;
+            order.push_back(*exit);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef EXITGRAPH_H
+#define EXITGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+class Location;
+
+// The World's exits as a compressed sparse row graph: the exits of Location i
+// are targets[offsets[i] .. offsets[i + 1]). Exits never change after a World
+// is built, so the graph is built once and read without locks.
+class ExitGraph {
+private:
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> targets;
+
+public:
+    // Constructors
+    ExitGraph();
+    explicit ExitGraph(const std::vector<Location>& locations);
+
+    std::size_t size() const;
+    const std::uint32_t* exits_begin(std::uint32_t location) const;
+    const std::uint32_t* exits_end(std::uint32_t location) const;
+    const std::vector<std::uint32_t>& get_offsets() const;
+    const std::vector<std::uint32_t>& get_targets() const;
+
+    // Breadth-first search from `start` out to `max_moves` (negative for no limit).
+    // Fills `order` with the Locations reached, nearest first, and `distances`
+    // (sized to the graph, -1 where unreached) with how many moves each one takes.
+    void distances_from(std::uint32_t start, int max_moves, std::vector<std::uint32_t>& order,
+                        std::vector<int>& distances) const;
+};
+
+#endif
@@ -7,67 +7,73 @@
  * This file contains the implementation of the Game class, which serves as the core
  * logic for the GVZork text-based adventure game. The Game class manages the game
  * world, player interactions, and the command system using the Command Pattern.
- * It also handles the game loop, inventory management, and win/lose conditions.
+ * It also handles inventory management and win/lose conditions. The Game never
+ * touches the console: commands go in as strings and responses come back as
+ * strings, so front ends (see Console) decide how to do I/O.
  */
 
 #include "Game.h"
-#include <iostream>
-#include <sstream>
+#include "Bytes.h"
+#include "Packer.h"
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <ctime>
-#include <cstdlib>
 
 /**
  * @brief Constructor for the Game class.
  *
- * Initializes the game by setting up the world, commands, and default values.
+ * Starts a single-player session in a World of its own.
+ */
+Game::Game() : Game(std::make_shared<World>()) {}
+
+/**
+ * @brief Constructs a session in the given World.
+ *
+ * Sessions that share a World see each other's changes: Items taken by one
+ * player disappear for everyone and calories given to the Elf count for all.
  * The player's starting location is randomly selected from the available locations.
+ *
+ * @param world The World to play in.
+ * @param shared Whether other sessions may play in it too.
  */
-Game::Game() : current_weight(0), calories_needed(500), in_progress(true) {
-    create_world();
+Game::Game(std::shared_ptr<World> world, bool shared)
+    : current_weight(0), world(std::move(world)), release(0), shared(shared), in_progress(true),
+      rng(std::random_device{}()), output_mode(OutputMode::FULL) {
     commands = setup_commands();
     current_location = random_location();
 }
 
 /**
- * @brief Creates the game world with Locations, NPCs, and Items.
+ * @brief Constructs a session that follows a WorldHost's releases.
+ *
+ * The session starts in the current release's World and moves to each new
+ * release at its next command, so content can be reloaded while it plays.
  *
- * This method initializes all Locations, NPCs, and Items in the game. It connects
- * Locations via their neighbor maps and populates them with NPCs and Items.
- * Each Location is created with a name, description, and relationships to other
- * Locations. NPCs and Items are added to their respective Locations.
+ * @param host Where the World and its reloads come from.
  */
-void Game::create_world() {
-    // Example Locations
-    Location* padnos = new Location("Padnos Hall", "Lots of science labs are in this building.");
-    Location* zumberge = new Location("Zumberge Field", "A large open field on campus.");
-    Location* kirkhoff = new Location("Kirkhoff Center", "The student union with restaurants and stores.");
-    Location* woods = new Location("Woods", "A mysterious forest behind campus.");
-
-    // Add neighbors
-    padnos->add_location("east", zumberge);
-    zumberge->add_location("west", padnos);
-    zumberge->add_location("north", kirkhoff);
-    kirkhoff->add_location("south", zumberge);
-    kirkhoff->add_location("west", woods);
-    woods->add_location("east", kirkhoff);
+Game::Game(std::shared_ptr<WorldHost> host) : Game(host, host->get_release()) {}
 
-    // Add NPCs
-    std::vector<std::string> elf_messages = {"Bring me food!", "I need 500 calories!", "You're almost there!"};
-    NPC elf("Elf", "A magical creature who can save GVSU.", elf_messages);
-    woods->add_npc(elf);
+Game::Game(std::shared_ptr<WorldHost> host, std::shared_ptr<const WorldHost::Release> current)
+    : Game(WorldHost::world_for(*current), current->world != nullptr) {
+    this->host = std::move(host);
+    release = current->version;
+}
 
-    // Add Items
-    Item cookie("Cookie", "A delicious M&M cookie.", 10, 0.5);
-    Item nail("Rusty Nail", "A rusty nail (I hope you've had a tetanus shot).", 0, 1);
-    padnos->add_item(cookie);
-    zumberge->add_item(nail);
+/**
+ * @brief Wakes a hibernated session in the host's current release.
+ *
+ * @param host Where the World and its reloads come from.
+ * @param saved Bytes written by save.
+ * @throws std::invalid_argument If the bytes are not a saved session.
+ */
+Game::Game(std::shared_ptr<WorldHost> host, std::string_view saved) : Game(host, host->get_release(), saved) {}
 
-    // Store locations
-    locations.push_back(*padnos);
-    locations.push_back(*zumberge);
-    locations.push_back(*kirkhoff);
-    locations.push_back(*woods);
+Game::Game(std::shared_ptr<WorldHost> host, std::shared_ptr<const WorldHost::Release> current, std::string_view saved)
+    : Game(std::move(host), current) {
+    restore(*current, saved);
 }
 
 /**
@@ -90,70 +96,362 @@ std::map<std::string, std::function<void(std::vector<std::string>)>> Game::setup
     cmds["items"] = [this](std::vector<std::string> tokens) { show_items(tokens); };
     cmds["look"] = [this](std::vector<std::string> tokens) { look(tokens); };
     cmds["quit"] = [this](std::vector<std::string> tokens) { quit(tokens); };
+    cmds["output"] = [this](std::vector<std::string> tokens) { output(tokens); };
     cmds["teleport"] = [this](std::vector<std::string> tokens) { teleport(tokens); };
     cmds["magic"] = [this](std::vector<std::string> tokens) { magic(tokens); };
+    cmds["undo"] = [this](std::vector<std::string> tokens) { undo(tokens); };
+    cmds["redo"] = [this](std::vector<std::string> tokens) { redo(tokens); };
+    cmds["search"] = [this](std::vector<std::string> tokens) { search(tokens); };
+    cmds["query"] = [this](std::vector<std::string> tokens) { query(tokens); };
+    cmds["pack"] = [this](std::vector<std::string> tokens) { pack(tokens); };
     return cmds;
 }
 
+/**
+ * @brief Moves this session onto a newly published release.
+ *
+ * Runs between commands, so a command in flight during a reload finishes in
+ * the World it started in. The player's own state is carried over by stable
+ * id: the current Location by name, and held Items by name, taking the new
+ * content's values where it still defines them. In a World of its own the
+ * Elf's progress comes along too. Undo history refers to the old World's
+ * Locations and is dropped.
+ *
+ * @param next The release to move to.
+ */
+void Game::migrate(const WorldHost::Release& next) {
+    std::shared_ptr<World> target = WorldHost::world_for(next);
+    if (!next.world) target->continue_from(*world);
+    std::string here = current_location->get_name();
+    world = std::move(target);
+    release = next.version;
+    shared = next.world != nullptr;
+
+    current_location = world->find_location(here);
+    if (!current_location) current_location = random_location();
+    current_weight = 0;
+    for (auto& item : inventory) {
+        if (const Item* updated = world->get_content().find_item(item.get_name())) item = *updated;
+        current_weight += item.get_weight();
+    }
+    history.clear();
+    last_view = LocationView();
+    response += "The world has been updated.\n";
+}
+
+/**
+ * @brief Writes the session in a compact binary form for hibernation and the journal.
+ *
+ * Only what cannot be rebuilt is kept: the release it played in, the current
+ * Location by name, the inventory and, for a World of its own, the World's
+ * progress. The time of the save comes last, so same_state can ignore it.
+ * Undo history is not saved.
+ *
+ * @param out Receives the bytes (appended).
+ */
+void Game::save(std::string& out) const {
+    ByteWriter writer(out);
+    writer.put<std::uint8_t>(SAVE_FORMAT);
+    writer.put<std::uint64_t>(release);
+    writer.put_text(current_location->get_name());
+    writer.put<std::uint8_t>(static_cast<std::uint8_t>(output_mode));
+    writer.put<std::int32_t>(current_weight);
+    writer.put<std::uint16_t>(static_cast<std::uint16_t>(inventory.size()));
+    for (const auto& item : inventory) {
+        writer.put_text(item.get_name());
+        writer.put_text(item.get_description());
+        writer.put<std::int32_t>(item.get_calories());
+        writer.put<float>(item.get_weight());
+    }
+    std::string progress;
+    if (!host || !host->get_release()->world) world->save_progress(progress);
+    writer.put_blob(progress);
+    writer.put<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Two saves hold the same state if everything but their times matches
+bool Game::same_state(std::string_view saved, std::string_view other) {
+    constexpr std::size_t TIME = sizeof(std::int64_t);
+    return saved.size() == other.size() && saved.size() >= TIME &&
+           saved.substr(0, saved.size() - TIME) == other.substr(0, other.size() - TIME);
+}
+
+/**
+ * @brief Restores a session written by save into the given release.
+ *
+ * The player goes back to the Location of the same name (a random one if the
+ * content no longer has it). If content was reloaded while the session slept,
+ * held Items are refreshed by name the same way migrate does. A World of its
+ * own is rebuilt from the content, as if every Item had respawned, and takes
+ * back its saved progress.
+ *
+ * @param current The release this session now plays in.
+ * @param saved Bytes from save.
+ * @throws std::invalid_argument If the bytes are not a saved session.
+ */
+void Game::restore(const WorldHost::Release& current, std::string_view saved) {
+    ByteReader reader(saved, "Saved session is corrupt.");
+    if (reader.get<std::uint8_t>() != SAVE_FORMAT) throw std::invalid_argument("Saved session is corrupt.");
+    std::uint64_t saved_release = reader.get<std::uint64_t>();
+    std::string here = reader.text();
+    auto mode = reader.get<std::uint8_t>();
+    int weight = reader.get<std::int32_t>();
+    std::vector<Item> items;
+    for (auto count = reader.get<std::uint16_t>(); count > 0; count--) {
+        std::string name = reader.text();
+        std::string description = reader.text();
+        int calories = reader.get<std::int32_t>();
+        float item_weight = reader.get<float>();
+        items.emplace_back(name, PackedText(description, world->get_content().get_dictionary()), calories, item_weight);
+    }
+    std::string_view progress = reader.blob();
+    std::chrono::system_clock::time_point saved_at{std::chrono::milliseconds(reader.get<std::int64_t>())};
+    if (mode > static_cast<std::uint8_t>(OutputMode::BINARY) || !reader.at_end()) {
+        throw std::invalid_argument("Saved session is corrupt.");
+    }
+
+    if (!current.world && !progress.empty()) world->restore_progress(progress, std::chrono::system_clock::now() - saved_at);
+    if (Location* location = world->find_location(here)) current_location = location;
+    output_mode = static_cast<OutputMode>(mode);
+    inventory = std::move(items);
+    if (saved_release == current.version) {
+        current_weight = weight;
+        return;
+    }
+    current_weight = 0;
+    for (auto& item : inventory) {
+        if (const Item* updated = world->get_content().find_item(item.get_name())) item = *updated;
+        current_weight += item.get_weight();
+    }
+}
+
 /**
  * @brief Selects a random Location from the game world.
  *
- * This method generates a random index and returns the corresponding Location
- * from the `locations` vector.
+ * This method generates a random index with the session's own generator and
+ * returns the corresponding Location from the World.
  *
  * @return A pointer to a randomly selected Location.
  */
 Location* Game::random_location() {
-    srand(time(nullptr));
-    int index = rand() % locations.size();
-    return &locations[index];
+    std::vector<Location>& locations = world->get_locations();
+    std::uniform_int_distribution<std::size_t> index(0, locations.size() - 1);
+    return &locations[index(rng)];
 }
 
 /**
- * @brief The core game loop.
+ * @brief Renders the current Location before each prompt.
  *
- * This method runs the main game loop, prompting the player for input and
- * executing commands until the game ends. It handles user input, tokenizes it,
- * and executes the corresponding command from the command map.
+ * In full mode the whole Location is printed every turn. In diff mode only the
+ * Items, NPCs, and Directions that changed since the last render are printed,
+ * and the full Location is printed only when the player arrives somewhere new.
  */
-void Game::play() {
-    std::cout << "Welcome to GVZork!\n";
-    std::cout << "Your goal is to collect edible items and bring them to the Elf in the Woods.\n";
-    std::cout << "Type 'help' for a list of commands.\n";
+void Game::render() {
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
+    LocationView view(*current_location);
+    if (output_mode != OutputMode::DIFF || !view.write_diff(response, last_view)) {
+        response += "\nYou are at: " + current_location->to_string() + "\n";
+    }
+    last_view = view;
+}
 
-    while (in_progress) {
-        std::cout << "\nYou are at: " << *current_location << "\n";
-        std::cout << "What is your command? ";
-        std::string input;
-        std::getline(std::cin, input);
+/**
+ * @brief Serializes the structured event for the command that just ran.
+ *
+ * Used by the JSON and binary output modes. The event is serialized into a
+ * reusable buffer, which is allocated on first use (idle text sessions never
+ * pay for it) and only grows if an event does not fit.
+ *
+ * @return The encoded event, valid until the next call into the Game.
+ */
+std::string_view Game::write_event() {
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
+    const Location* first = world->get_locations().data();
+    ProtocolEvent event{world->location_id(current_location), current_location, first, &inventory_added,
+                        &inventory_removed, world->get_calories_needed(), is_in_progress(), response};
+    if (protocol_buffer.empty()) protocol_buffer.resize(4096);
+    auto format = output_mode == OutputMode::JSON ? ProtocolWriter::Format::JSON : ProtocolWriter::Format::BINARY;
+    ProtocolWriter writer(protocol_buffer.data(), protocol_buffer.size(), format);
+    writer.write_event(event);
+    while (writer.overflowed()) {
+        protocol_buffer.resize(protocol_buffer.size() * 2);
+        writer = ProtocolWriter(protocol_buffer.data(), protocol_buffer.size(), format);
+        writer.write_event(event);
+    }
+    return writer.data();
+}
 
-        // Tokenize input
-        std::vector<std::string> tokens;
-        std::istringstream iss(input);
-        std::string token;
-        while (iss >> token) {
-            tokens.push_back(token);
-        }
+/**
+ * @brief Returns the welcome text shown once when a session starts.
+ *
+ * @return The welcome text.
+ */
+std::string Game::welcome() const {
+    return "Welcome to GVZork!\n"
+           "Your goal is to collect edible items and bring them to the Elf in the Woods.\n"
+           "Type 'help' for a list of commands.\n";
+}
+
+/**
+ * @brief Returns the text shown before the next command is read.
+ *
+ * In text modes this is the Location render followed by the command question.
+ * Structured modes have no prompt.
+ *
+ * @return The prompt, valid until the next call into the Game.
+ */
+std::string_view Game::prompt() {
+    response.clear();
+    world->advance();
+    if (output_mode == OutputMode::JSON || output_mode == OutputMode::BINARY) return response;
+    render();
+    response += "What is your command? ";
+    return response;
+}
 
-        if (tokens.empty()) continue;
+/**
+ * @brief Executes one line of player input.
+ *
+ * A line may hold several commands separated by ';' (e.g. "take Cookie; go east").
+ * They run in order as one batch and stop early if the game ends. The combined
+ * text is returned directly in text modes; in structured modes the batch becomes
+ * a single JSON line or binary frame. Either way the Location is rendered once,
+ * by the next prompt, rather than after every command. A reloaded World is
+ * picked up first, then World events that came due while the player was idle run.
+ *
+ * @param line The raw input line.
+ * @return The response, valid until the next call into the Game.
+ */
+std::string_view Game::execute(std::string_view line) {
+    response.clear();
+    inventory_added.clear();
+    inventory_removed.clear();
+    if (host && host->get_version() != release) migrate(*host->get_release());
+    world->advance();
+
+    bool structured = output_mode == OutputMode::JSON || output_mode == OutputMode::BINARY;
+    bool ran = false;
+    std::size_t start = 0;
+    while (start <= line.size() && is_in_progress()) {
+        std::size_t end = line.find(';', start);
+        if (end == std::string_view::npos) end = line.size();
+        ran |= run_command(line.substr(start, end - start));
+        start = end + 1;
+    }
 
-        std::string command = tokens[0];
-        tokens.erase(tokens.begin());
+    if (structured && ran) return write_event();
+    return response;
+}
 
-        // Execute command
-        if (commands.find(command) != commands.end()) {
-            commands[command](tokens);
-        } else {
-            std::cout << "Unknown command. Type 'help' for a list of commands.\n";
-        }
+/**
+ * @brief Tokenizes and dispatches a single command.
+ *
+ * @param text One command with its arguments.
+ * @return False if the text was blank.
+ */
+bool Game::run_command(std::string_view text) {
+    // Tokenize input
+    std::vector<std::string> tokens;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+        std::size_t start = pos;
+        while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+        if (pos > start) tokens.emplace_back(text.substr(start, pos - start));
     }
 
-    // End game message
-    if (calories_needed <= 0) {
-        std::cout << "Congratulations! The Elf has enough calories to save GVSU!\n";
+    if (tokens.empty()) return false;
+
+    std::string command = tokens[0];
+    tokens.erase(tokens.begin());
+
+    // Execute command; whatever it changed becomes one undoable turn
+    auto handler = commands.find(command);
+    if (handler != commands.end()) {
+        handler->second(tokens);
     } else {
-        std::cout << "You failed to save GVSU. Better luck next time!\n";
+        response += "Unknown command. Type 'help' for a list of commands.\n";
     }
+    history.commit();
+    return true;
+}
+
+/**
+ * @brief Removes one Item with the given name from the inventory.
+ *
+ * @param name The name of the Item to remove.
+ */
+void Game::remove_from_inventory(const std::string& name) {
+    auto it = std::find_if(inventory.begin(), inventory.end(), [&name](const Item& i) { return i.get_name() == name; });
+    if (it != inventory.end()) inventory.erase(it);
+}
+
+/**
+ * @brief Returns the end game message.
+ *
+ * @return The win or loss text, or nothing in structured modes where the final
+ *         event already reports the outcome.
+ */
+std::string Game::outcome() const {
+    if (output_mode == OutputMode::JSON || output_mode == OutputMode::BINARY) return "";
+    if (world->is_won()) return "Congratulations! The Elf has enough calories to save GVSU!\n";
+    return "You failed to save GVSU. Better luck next time!\n";
+}
+
+/**
+ * @brief Reports whether the game loop should keep reading commands.
+ *
+ * @return True until the player quits or the Elf has been given enough calories
+ *         by any player in the World.
+ */
+bool Game::is_in_progress() const { return in_progress && !world->is_won(); }
+
+/**
+ * @brief Runs the World's rule for an action on an Item here.
+ *
+ * Effects run in the order the rule lists them. Calories fed to the Elf are
+ * added to `calories_given` so the caller can undo them.
+ *
+ * @param action What the player did.
+ * @param item The Item it was done with.
+ * @param calories_given Incremented by the calories fed to the Elf.
+ * @return False if the player keeps the Item: the rule says so, or no rule applies.
+ */
+bool Game::apply_rule(RuleBook::Action action, const Item& item, int& calories_given) {
+    const RuleBook::Rule* rule = world->find_rule(action, item, current_location);
+    if (rule == nullptr) {
+        if (action == RuleBook::Action::GIVE) response += "Nothing happens.\n";
+        return false;
+    }
+    bool parted = true;
+    for (const auto& effect : rule->effects) {
+        switch (effect.kind) {
+            case RuleBook::Effect::Kind::SAY: {
+                std::size_t start = response.size();
+                response += effect.text;
+                for (const auto& [field, value] : {std::pair<std::string_view, std::string>{"{item}", item.get_name()},
+                                                   {"{calories}", std::to_string(item.get_calories())}}) {
+                    for (std::size_t at = response.find(field, start); at != std::string::npos;
+                         at = response.find(field, at + value.size())) {
+                        response.replace(at, field.size(), value);
+                    }
+                }
+                break;
+            }
+            case RuleBook::Effect::Kind::FEED:
+                calories_given += item.get_calories();
+                world->feed(item.get_calories());
+                break;
+            case RuleBook::Effect::Kind::TELEPORT:
+                current_location = random_location();
+                break;
+            case RuleBook::Effect::Kind::KEEP:
+                parted = false;
+                break;
+        }
+    }
+    return parted;
 }
 
 /**
@@ -164,36 +462,39 @@ void Game::play() {
  * @param tokens Unused parameter included for consistency with other commands.
  */
 void Game::show_help(std::vector<std::string> tokens) {
-    std::cout << "Available commands:\n";
+    response += "Available commands:\n";
     for (const auto& cmd : commands) {
-        std::cout << "- " << cmd.first << "\n";
+        response += "- " + cmd.first + "\n";
     }
     std::time_t now = std::time(nullptr);
-    std::cout << "Current time: " << std::ctime(&now);
+    response += "Current time: ";
+    response += std::ctime(&now);
 }
 
 /**
  * @brief Allows the player to talk to an NPC.
  *
  * This method checks if the specified NPC is in the current Location. If found,
- * it retrieves and prints the NPC's current message.
+ * the NPC replies: scripted NPCs run their dialogue against the player's
+ * inventory and the Elf's goal, others print their next message. The NPC in
+ * the Location is used, not a copy, so its conversation state carries over.
  *
  * @param tokens A vector containing the name of the NPC to talk to.
  */
 void Game::talk(std::vector<std::string> tokens) {
     if (tokens.empty()) {
-        std::cout << "Who do you want to talk to?\n";
+        response += "Who do you want to talk to?\n";
         return;
     }
 
-    std::string target = tokens[0];
-    for (auto& npc : current_location->get_npcs()) {
-        if (npc.get_name() == target) {
-            std::cout << npc.get_message() << "\n";
-            return;
-        }
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
+    NPC* npc = current_location->find_npc(tokens[0]);
+    if (npc == nullptr) {
+        response += "No such NPC in this location.\n";
+        return;
     }
-    std::cout << "No such NPC in this location.\n";
+    npc->respond(inventory, world->get_calories_needed(), response);
+    response += "\n";
 }
 
 /**
@@ -206,97 +507,156 @@ void Game::talk(std::vector<std::string> tokens) {
  */
 void Game::meet(std::vector<std::string> tokens) {
     if (tokens.empty()) {
-        std::cout << "Who do you want to meet?\n";
+        response += "Who do you want to meet?\n";
         return;
     }
 
     std::string target = tokens[0];
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
     for (auto& npc : current_location->get_npcs()) {
         if (npc.get_name() == target) {
-            std::cout << npc.get_description() << "\n";
+            response += npc.get_description() + "\n";
             return;
         }
     }
-    std::cout << "No such NPC in this location.\n";
+    response += "No such NPC in this location.\n";
 }
 
 /**
  * @brief Allows the player to take an Item.
  *
  * This method checks if the specified Item is in the current Location. If found,
- * it adds the Item to the player's inventory and updates the carried weight.
+ * it adds the Item to the player's inventory and updates the carried weight, then
+ * applies whatever take rule the World has for it.
  *
  * @param tokens A vector containing the name of the Item to take.
  */
 void Game::take(std::vector<std::string> tokens) {
     if (tokens.empty()) {
-        std::cout << "What do you want to take?\n";
+        response += "What do you want to take?\n";
         return;
     }
 
     std::string target = tokens[0];
-    for (auto& item : current_location->get_items()) {
-        if (item.get_name() == target) {
-            if (current_weight + item.get_weight() > 30) {
-                std::cout << "You cannot carry that much weight.\n";
-                return;
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
+    std::optional<Item> found = current_location->find_item(target);
+    if (!found) {
+        response += "No such item in this location.\n";
+        return;
+    }
+    const Item& item = *found;
+    if (current_weight + item.get_weight() > MAX_WEIGHT) {
+        response += "You cannot carry that much weight.\n";
+        return;
+    }
+    int weight_before = current_weight;
+    inventory.push_back(item);
+    inventory_added.push_back(item);
+    current_weight += item.get_weight();
+    response += "You took the " + item.get_name() + ".\n";
+    current_location->remove_item(item.get_name());
+    world->items_changed(current_location);
+    world->item_taken(current_location, item);
+
+    Location* from = current_location;
+    int calories_given = 0;
+    apply_rule(RuleBook::Action::TAKE, item, calories_given);
+    Location* location_after = current_location;
+    int weight_after = current_weight;
+    history.record(
+        [this, from, item, weight_before, calories_given] {
+            std::lock_guard<std::mutex> lock(world->lock_for(from));
+            // A respawn may have put a copy back already; returning this one would make two
+            if (from->find_item(item.get_name())) {
+                response += "The " + item.get_name() + " is already back where it was.\n";
+                return false;
             }
+            remove_from_inventory(item.get_name());
+            inventory_removed.push_back(item);
+            from->add_item(item);
+            world->items_changed(from);
+            current_location = from;
+            current_weight = weight_before;
+            world->feed(-calories_given);
+            return true;
+        },
+        [this, from, item, location_after, weight_after, calories_given] {
+            std::lock_guard<std::mutex> lock(world->lock_for(from));
+            // Someone else may have taken it in the meantime
+            if (!from->remove_item(item.get_name())) {
+                response += "It's no longer here.\n";
+                return false;
+            }
+            world->items_changed(from);
+            world->item_taken(from, item);
             inventory.push_back(item);
-            current_weight += item.get_weight();
-            std::cout << "You took the " << item.get_name() << ".\n";
-            current_location->get_items().erase(
-                std::remove_if(current_location->get_items().begin(), current_location->get_items().end(),
-                               [&item](const Item& i) { return i.get_name() == item.get_name(); }),
-                current_location->get_items().end());
-            return;
-        }
-    }
-    std::cout << "No such item in this location.\n";
+            inventory_added.push_back(item);
+            current_location = location_after;
+            current_weight = weight_after;
+            world->feed(calories_given);
+            return true;
+        });
 }
 
 /**
- * @brief Allows the player to give an Item to the Elf.
+ * @brief Allows the player to give an Item away.
  *
- * This method checks if the specified Item is in the player's inventory. If found,
- * it removes the Item from the inventory and updates the carried weight. If the
- * current Location is the Woods, it checks if the Item is edible. If edible, it
- * reduces the Elf's calorie requirement; otherwise, it teleports the player to a
- * random Location.
+ * What happens is up to the World's give rule for the Item and the current
+ * Location; under the standard rules an edible Item given in the Woods feeds
+ * the Elf and an inedible one gets the player teleported away. The Item leaves
+ * the inventory unless the rule says to keep it, or no rule applies.
  *
  * @param tokens A vector containing the name of the Item to give.
  */
 void Game::give(std::vector<std::string> tokens) {
     if (tokens.empty()) {
-        std::cout << "What do you want to give?\n";
+        response += "What do you want to give?\n";
         return;
     }
 
     std::string target = tokens[0];
-    for (auto& item : inventory) {
-        if (item.get_name() == target) {
-            if (current_location->get_name() == "Woods") {
-                if (item.get_calories() > 0) {
-                    calories_needed -= item.get_calories();
-                    std::cout << "You gave the Elf " << item.get_calories() << " calories.\n";
-                    if (calories_needed <= 0) {
-                        in_progress = false;
-                    }
-                } else {
-                    std::cout << "The Elf is displeased and teleports you away!\n";
-                    current_location = random_location();
-                }
-            } else {
-                std::cout << "You can only give items to the Elf in the Woods.\n";
+    for (auto& match : inventory) {
+        if (match.get_name() == target) {
+            Item item = match;
+            Location* location_before = current_location;
+            int calories_given = 0;
+            bool parted = apply_rule(RuleBook::Action::GIVE, item, calories_given);
+
+            int weight_before = current_weight;
+            if (parted) {
+                inventory_removed.push_back(item);
+                remove_from_inventory(item.get_name());
+                current_weight -= item.get_weight();
             }
-            inventory.erase(
-                std::remove_if(inventory.begin(), inventory.end(),
-                               [&item](const Item& i) { return i.get_name() == item.get_name(); }),
-                inventory.end());
-            current_weight -= item.get_weight();
+
+            Location* location_after = current_location;
+            int weight_after = current_weight;
+            if (!parted && calories_given == 0 && location_after == location_before) return;
+            history.record(
+                [this, item, parted, location_before, weight_before, calories_given] {
+                    if (parted) {
+                        inventory.push_back(item);
+                        inventory_added.push_back(item);
+                    }
+                    current_location = location_before;
+                    current_weight = weight_before;
+                    world->feed(-calories_given);
+                    return true;
+                },
+                [this, item, parted, location_after, weight_after, calories_given] {
+                    if (parted) {
+                        remove_from_inventory(item.get_name());
+                        inventory_removed.push_back(item);
+                    }
+                    current_location = location_after;
+                    current_weight = weight_after;
+                    world->feed(calories_given);
+                    return true;
+                });
             return;
         }
     }
-    std::cout << "No such item in your inventory.\n";
+    response += "No such item in your inventory.\n";
 }
 
 /**
@@ -309,18 +669,36 @@ void Game::give(std::vector<std::string> tokens) {
  */
 void Game::go(std::vector<std::string> tokens) {
     if (tokens.empty()) {
-        std::cout << "Where do you want to go?\n";
+        response += "Where do you want to go?\n";
         return;
     }
 
     std::string direction = tokens[0];
     auto neighbors = current_location->get_locations();
     if (neighbors.find(direction) != neighbors.end()) {
+        Location* from = current_location;
+        Location* to = neighbors[direction];
+        bool was_visited = from->get_visited();
         current_location->set_visited();
-        current_location = neighbors[direction];
-        std::cout << "You moved " << direction << ".\n";
+        current_location = to;
+        response += "You moved " + direction + ".\n";
+        // Visited marks are shared by everyone in a shared World, so only a World of one's own forgets them
+        history.record(
+            [this, from, was_visited] {
+                if (!was_visited && !shared) {
+                    std::lock_guard<std::mutex> lock(world->lock_for(from));
+                    from->reset_visited();
+                }
+                current_location = from;
+                return true;
+            },
+            [this, from, to] {
+                from->set_visited();
+                current_location = to;
+                return true;
+            });
     } else {
-        std::cout << "You cannot go that way.\n";
+        response += "You cannot go that way.\n";
     }
 }
 
@@ -335,13 +713,13 @@ void Game::go(std::vector<std::string> tokens) {
  */
 void Game::show_items(std::vector<std::string> tokens) {
     if (inventory.empty()) {
-        std::cout << "You are not carrying any items.\n";
+        response += "You are not carrying any items.\n";
     } else {
-        std::cout << "You are carrying:\n";
+        response += "You are carrying:\n";
         for (const auto& item : inventory) {
-            std::cout << "- " << item << "\n";
+            response += "- " + item.to_string() + "\n";
         }
-        std::cout << "Total weight: " << current_weight << " lb\n";
+        response += "Total weight: " + std::to_string(current_weight) + " lb\n";
     }
 }
 
@@ -349,12 +727,15 @@ void Game::show_items(std::vector<std::string> tokens) {
  * @brief Displays details about the current Location.
  *
  * This method prints the current Location's description, NPCs, Items, and
- * available directions to move.
+ * available directions to move. It always prints the full Location, so it also
+ * serves as the refresh in diff output mode.
  *
  * @param tokens Unused parameter included for consistency with other commands.
  */
 void Game::look(std::vector<std::string> tokens) {
-    std::cout << *current_location << "\n";
+    std::lock_guard<std::mutex> lock(world->lock_for(current_location));
+    response += current_location->to_string() + "\n";
+    last_view = LocationView(*current_location);
 }
 
 /**
@@ -365,10 +746,32 @@ void Game::look(std::vector<std::string> tokens) {
  * @param tokens Unused parameter included for consistency with other commands.
  */
 void Game::quit(std::vector<std::string> tokens) {
-    std::cout << "Quitting the game. Goodbye!\n";
+    response += "Quitting the game. Goodbye!\n";
     in_progress = false;
 }
 
+/**
+ * @brief Switches how command results are reported.
+ *
+ * "full" prints the whole Location every turn. "diff" prints only changes since
+ * the last render. "json" and "binary" replace the text with one structured
+ * event per command (a JSON line or a length-prefixed frame) for automated clients.
+ *
+ * @param tokens A vector containing the output mode.
+ */
+void Game::output(std::vector<std::string> tokens) {
+    static const std::map<std::string, OutputMode> modes = {
+        {"full", OutputMode::FULL}, {"diff", OutputMode::DIFF},
+        {"json", OutputMode::JSON}, {"binary", OutputMode::BINARY}};
+    auto mode = tokens.empty() ? modes.end() : modes.find(tokens[0]);
+    if (mode == modes.end()) {
+        response += "Usage: output full|diff|json|binary\n";
+        return;
+    }
+    output_mode = mode->second;
+    response += "Output mode set to " + tokens[0] + ".\n";
+}
+
 /**
  * @brief Teleports the player to a random Location.
  *
@@ -377,8 +780,19 @@ void Game::quit(std::vector<std::string> tokens) {
  * @param tokens Unused parameter included for consistency with other commands.
  */
 void Game::teleport(std::vector<std::string> tokens) {
+    Location* from = current_location;
     current_location = random_location();
-    std::cout << "You have been teleported to " << current_location->get_name() << ".\n";
+    Location* to = current_location;
+    history.record(
+        [this, from] {
+            current_location = from;
+            return true;
+        },
+        [this, to] {
+            current_location = to;
+            return true;
+        });
+    response += "You have been teleported to " + current_location->get_name() + ".\n";
 }
 
 /**
@@ -389,6 +803,211 @@ void Game::teleport(std::vector<std::string> tokens) {
  * @param tokens Unused parameter included for consistency with other commands.
  */
 void Game::magic(std::vector<std::string> tokens) {
-    std::cout << "Magic happens! Your inventory weight is halved.\n";
+    response += "Magic happens! Your inventory weight is halved.\n";
+    int weight_before = current_weight;
     current_weight /= 2;
+    int weight_after = current_weight;
+    history.record(
+        [this, weight_before] {
+            current_weight = weight_before;
+            return true;
+        },
+        [this, weight_after] {
+            current_weight = weight_after;
+            return true;
+        });
+}
+
+/**
+ * @brief Reverts the most recent command that changed the game.
+ *
+ * Only the state that command touched is restored (e.g. the displeased Elf's
+ * teleport and the lost Item), so undoing costs nothing proportional to the
+ * size of the world. Other players may have changed the World since, in which
+ * case a change that no longer fits (an Item taken again, or already respawned)
+ * is refused with a message and the turn is left as it was.
+ *
+ * @param tokens Unused parameter included for consistency with other commands.
+ */
+void Game::undo(std::vector<std::string> tokens) {
+    switch (history.undo()) {
+        case History::Step::DONE: response += "You undo your last action.\n"; break;
+        case History::Step::NOTHING: response += "There is nothing to undo.\n"; break;
+        case History::Step::BLOCKED: break;   // the change said why
+    }
+}
+
+/**
+ * @brief Reapplies the most recently undone command.
+ *
+ * @param tokens Unused parameter included for consistency with other commands.
+ */
+void Game::redo(std::vector<std::string> tokens) {
+    switch (history.redo()) {
+        case History::Step::DONE: response += "You redo your last action.\n"; break;
+        case History::Step::NOTHING: response += "There is nothing to redo.\n"; break;
+        case History::Step::BLOCKED: break;   // the change said why
+    }
+}
+
+/**
+ * @brief Searches the names and descriptions of everything in the World.
+ *
+ * Results are ranked by relevance. Items and NPCs are listed with the Location
+ * they started out in.
+ *
+ * @param tokens The words to search for.
+ */
+void Game::search(std::vector<std::string> tokens) {
+    if (tokens.empty()) {
+        response += "What do you want to search for?\n";
+        return;
+    }
+
+    std::string query;
+    for (const auto& token : tokens) query += token + " ";
+    std::vector<SearchIndex::Result> results = world->get_search_index().search(query);
+    if (results.empty()) {
+        response += "Nothing matches that search.\n";
+        return;
+    }
+    const std::vector<Location>& locations = world->get_locations();
+    for (const auto& result : results) {
+        const SearchIndex::Document& document = *result.document;
+        response += "- " + document.name;
+        if (document.kind == SearchIndex::Kind::LOCATION) response += " (Location)";
+        else {
+            response += document.kind == SearchIndex::Kind::ITEM ? " (Item in " : " (NPC in ";
+            response += locations[static_cast<std::size_t>(document.location_id)].get_name() + ")";
+        }
+        response += ": ";
+        document.description.append_to(response);
+        response += "\n";
+    }
+}
+
+/**
+ * @brief Lists Items in the World by calories, weight, and distance.
+ *
+ * Conditions look like "calories>200", "weight<=5" or "within 10" (moves from
+ * here) and must all hold, e.g. "query calories>200 weight<5 within 10".
+ *
+ * @param tokens The conditions.
+ */
+void Game::query(std::vector<std::string> tokens) {
+    ItemIndex::Filter filter;
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        const std::string& token = tokens[i];
+        if (token == "within" && i + 1 < tokens.size()) {
+            int moves = -1;
+            auto [end, ec] = std::from_chars(tokens[i + 1].data(), tokens[i + 1].data() + tokens[i + 1].size(), moves);
+            if (ec != std::errc() || end != tokens[i + 1].data() + tokens[i + 1].size() || moves < 0) {
+                tokens.clear();
+                break;
+            }
+            filter.from_location = world->location_id(current_location);
+            filter.max_moves = moves;
+            i++;
+            continue;
+        }
+        std::size_t split = token.find_first_of("<=>");
+        std::string attribute = token.substr(0, split);
+        if (split == std::string::npos || (attribute != "calories" && attribute != "weight")) {
+            tokens.clear();
+            break;
+        }
+        std::size_t value_at = token.find_first_not_of("<=>", split);
+        std::string op = token.substr(split, value_at - split);
+        const char* first = token.data() + (value_at == std::string::npos ? token.size() : value_at);
+        const char* last = token.data() + token.size();
+        float value = 0;
+        auto [end, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc() || end != last || (op != "<" && op != "<=" && op != "=" && op != ">=" && op != ">")) {
+            tokens.clear();
+            break;
+        }
+        if (attribute == "calories") {
+            // Calories are whole numbers, so strict bounds move to the next integer
+            int low = static_cast<int>(std::ceil(value));
+            int high = static_cast<int>(std::floor(value));
+            if (op == ">") low = static_cast<int>(std::floor(value)) + 1;
+            if (op == "<") high = static_cast<int>(std::ceil(value)) - 1;
+            if (op[0] == '>' || op == "=") filter.min_calories = std::max(filter.min_calories, low);
+            if (op[0] == '<' || op == "=") filter.max_calories = std::min(filter.max_calories, high);
+        } else {
+            float low = op == ">" ? std::nextafter(value, INFINITY) : value;
+            float high = op == "<" ? std::nextafter(value, -INFINITY) : value;
+            if (op[0] == '>' || op == "=") filter.min_weight = std::max(filter.min_weight, low);
+            if (op[0] == '<' || op == "=") filter.max_weight = std::min(filter.max_weight, high);
+        }
+    }
+    if (tokens.empty()) {
+        response += "Usage: query [calories|weight](<|<=|=|>=|>)N ... [within MOVES]\n";
+        return;
+    }
+
+    std::shared_ptr<const ItemIndex> index = world->get_item_index();
+    std::vector<ItemIndex::Match> matches = index->find(filter, *world);
+    if (matches.empty()) {
+        response += "No items match.\n";
+        return;
+    }
+    const std::size_t shown = std::min<std::size_t>(matches.size(), 20);
+    for (std::size_t i = 0; i < shown; i++) write_match(*index, matches[i]);
+    if (matches.size() > shown) response += "...and " + std::to_string(matches.size() - shown) + " more.\n";
+}
+
+/**
+ * @brief Works out the most calories the player could carry from here.
+ *
+ * The candidates are the edible Items in every Location reachable from the
+ * current one, and the cap is what the player can still carry. Nothing is
+ * picked up; the answer is a shopping list.
+ *
+ * @param tokens Unused parameter included for consistency with other commands.
+ */
+void Game::pack(std::vector<std::string> tokens) {
+    std::shared_ptr<const ItemIndex> index = world->get_item_index();
+    ItemIndex::Filter filter;
+    filter.min_calories = 1;
+    filter.from_location = world->location_id(current_location);
+    std::vector<ItemIndex::Match> matches = index->find(filter, *world);
+
+    std::vector<int> calories;
+    std::vector<float> weights;
+    for (const auto& match : matches) {
+        calories.push_back(index->get_calories(match.row));
+        weights.push_back(index->get_weight(match.row));
+    }
+    float free = static_cast<float>(MAX_WEIGHT - current_weight);
+    Packer::Pack best = Packer::pack(calories, weights, free);
+    if (best.picked.empty()) {
+        response += "There is no food you can carry within reach.\n";
+        return;
+    }
+
+    char digits[32];
+    auto weight = std::to_chars(digits, digits + sizeof(digits), best.weight);
+    response += "Best pack: " + std::to_string(best.calories) + " calories, " + std::string(digits, weight.ptr) +
+                " lb of the " + std::to_string(MAX_WEIGHT - current_weight) + " lb you can still carry.\n";
+    for (std::size_t i : best.picked) write_match(*index, matches[i]);
+}
+
+/**
+ * @brief Appends one line describing an Item found by a query.
+ *
+ * @param index The index the match came from.
+ * @param match The matching row and its distance, if known.
+ */
+void Game::write_match(const ItemIndex& index, const ItemIndex::Match& match) {
+    std::uint32_t row = match.row;
+    char digits[32];
+    auto weight = std::to_chars(digits, digits + sizeof(digits), index.get_weight(row));
+    response += "- " + index.get_name(row) + "(" + std::to_string(index.get_calories(row)) + " calories)- " +
+                std::string(digits, weight.ptr) + " lb- in " + world->get_locations()[index.get_location(row)].get_name();
+    if (match.distance == 0) response += ", right here";
+    else if (match.distance > 0) {
+        response += ", " + std::to_string(match.distance) + (match.distance == 1 ? " move away" : " moves away");
+    }
+    response += "\n";
 }
\ No newline at end of file
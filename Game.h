@@ -5,30 +5,79 @@
 #include <map>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <random>
+#include <string_view>
 #include "Location.h"
+#include "World.h"
+#include "WorldHost.h"
 #include "Item.h"
+#include "LocationView.h"
+#include "ProtocolWriter.h"
+#include "History.h"
 
 class Game {
+public:
+    enum class OutputMode { FULL, DIFF, JSON, BINARY };
+
+    // Most weight a player can carry, in pounds
+    static constexpr int MAX_WEIGHT = 30;
+
+    // Version of the form written by save
+    static constexpr std::uint8_t SAVE_FORMAT = 2;
+
 private:
     std::map<std::string, std::function<void(std::vector<std::string>)>> commands;
     std::vector<Item> inventory;
     int current_weight;
-    std::vector<Location> locations;
+    std::shared_ptr<World> world;
+    std::shared_ptr<WorldHost> host;
+    std::uint64_t release;
+    bool shared;   // other sessions play in the same World
     Location* current_location;
-    int calories_needed;
     bool in_progress;
+    std::mt19937 rng;
+    OutputMode output_mode;
+    LocationView last_view;
+    std::vector<Item> inventory_added;
+    std::vector<Item> inventory_removed;
+    std::string response;
+    std::vector<char> protocol_buffer;
+    History history;
+
+    Game(std::shared_ptr<WorldHost> host, std::shared_ptr<const WorldHost::Release> current);
+    Game(std::shared_ptr<WorldHost> host, std::shared_ptr<const WorldHost::Release> current, std::string_view saved);
 
     // Helper methods
-    void create_world();
     std::map<std::string, std::function<void(std::vector<std::string>)>> setup_commands();
+    void migrate(const WorldHost::Release& next);
+    void restore(const WorldHost::Release& current, std::string_view saved);
     Location* random_location();
+    void render();
+    std::string_view write_event();
+    bool run_command(std::string_view text);
+    void remove_from_inventory(const std::string& name);
+    bool apply_rule(RuleBook::Action action, const Item& item, int& calories_given);
+    void write_match(const ItemIndex& index, const ItemIndex::Match& match);
 
 public:
-    // Constructor
+    // Constructors; sessions built on the same World play together, and say so with
+    // `shared` (a World of one's own is the default)
     Game();
+    explicit Game(std::shared_ptr<World> world, bool shared = false);
+    explicit Game(std::shared_ptr<WorldHost> host);
+    Game(std::shared_ptr<WorldHost> host, std::string_view saved);
+
+    // Session API used by front ends; no console I/O happens inside the Game
+    std::string welcome() const;
+    std::string_view prompt();
+    std::string_view execute(std::string_view line);
+    std::string outcome() const;
+    bool is_in_progress() const;
 
-    // Core game loop
-    void play();
+    // The session's state in a compact form, restored by the constructor above
+    void save(std::string& out) const;
+    static bool same_state(std::string_view saved, std::string_view other);
 
     // Command methods
     void show_help(std::vector<std::string> tokens);
@@ -40,10 +89,16 @@ public:
     void show_items(std::vector<std::string> tokens);
     void look(std::vector<std::string> tokens);
     void quit(std::vector<std::string> tokens);
+    void output(std::vector<std::string> tokens);
 
     // Custom commands
     void teleport(std::vector<std::string> tokens);
     void magic(std::vector<std::string> tokens);
+    void undo(std::vector<std::string> tokens);
+    void redo(std::vector<std::string> tokens);
+    void search(std::vector<std::string> tokens);
+    void query(std::vector<std::string> tokens);
+    void pack(std::vector<std::string> tokens);
 };
 
 #endif
\ No newline at end of file
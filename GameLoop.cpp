@@ -0,0 +1,94 @@
+/**
+ * @file GameLoop.cpp
+ * @brief Coroutine-based game loop for GVZork.
+ *
+ * play_async runs the same loop as Console::play, but instead of blocking on
+ * std::getline it co_awaits the next line. The caller (an event loop, usually)
+ * resumes it with GameLoop::feed whenever a line arrives and reads back the
+ * output produced until the loop suspends again.
+ */
+
+#include "GameLoop.h"
+
+// Promise
+GameLoop GameLoop::promise_type::get_return_object() {
+    return GameLoop(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+std::suspend_never GameLoop::promise_type::initial_suspend() noexcept { return {}; }
+std::suspend_always GameLoop::promise_type::final_suspend() noexcept { return {}; }
+void GameLoop::promise_type::return_value(std::string text) { output = std::move(text); }
+void GameLoop::promise_type::unhandled_exception() { error = std::current_exception(); }
+
+// Awaiting the next line
+bool GameLoop::NextLine::await_ready() const noexcept { return false; }
+
+void GameLoop::NextLine::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    promise = &handle.promise();
+    promise->output.swap(output);
+    output.clear();
+}
+
+std::optional<std::string> GameLoop::NextLine::await_resume() { return std::move(promise->input); }
+
+// Handle ownership
+GameLoop::GameLoop(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+GameLoop::GameLoop(GameLoop&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+GameLoop& GameLoop::operator=(GameLoop&& other) noexcept {
+    if (this != &other) {
+        if (handle) handle.destroy();
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+GameLoop::~GameLoop() {
+    if (handle) handle.destroy();
+}
+
+// Driving the loop
+std::string_view GameLoop::output() const { return handle.promise().output; }
+
+void GameLoop::resume(std::optional<std::string> line) {
+    if (done()) return;
+    handle.promise().input = std::move(line);
+    handle.resume();
+    if (handle.promise().error) std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+}
+
+std::string_view GameLoop::feed(std::string_view line) {
+    resume(std::string(line));
+    return output();
+}
+
+std::string_view GameLoop::close() {
+    resume(std::nullopt);
+    return output();
+}
+
+bool GameLoop::done() const { return !handle || handle.done(); }
+
+/**
+ * @brief The core game loop as a coroutine.
+ *
+ * Runs until the first prompt when called, then suspends on every prompt until
+ * a line is fed in. The end game message is co_returned.
+ *
+ * @param game The session to play.
+ * @param resumed True when waking a hibernated session: start by waiting for a line.
+ * @return The suspended loop.
+ */
+GameLoop play_async(Game& game, bool resumed) {
+    std::string out = resumed ? std::string() : game.welcome();
+    while (game.is_in_progress()) {
+        if (!resumed) out += game.prompt();
+        resumed = false;
+        std::optional<std::string> line = co_await GameLoop::NextLine{out};
+        if (!line) break;
+        out = game.execute(*line);
+    }
+    out += game.outcome();
+    co_return out;
+}
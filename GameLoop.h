@@ -0,0 +1,67 @@
+#ifndef GAMELOOP_H
+#define GAMELOOP_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "Game.h"
+
+// A game loop suspended between lines of input. Each suspended loop is a single
+// coroutine frame, so an event loop can keep thousands of them parked cheaply
+// instead of dedicating a thread blocked in std::getline to each player.
+class GameLoop {
+public:
+    struct promise_type {
+        std::string output;
+        std::optional<std::string> input;
+        std::exception_ptr error;
+
+        GameLoop get_return_object();
+        std::suspend_never initial_suspend() noexcept;
+        std::suspend_always final_suspend() noexcept;
+        void return_value(std::string text);
+        void unhandled_exception();
+    };
+
+    // co_await'ed by the loop: publishes `output` (leaving it empty) and resumes with the next line,
+    // or nothing at end of input
+    struct NextLine {
+        std::string& output;
+        promise_type* promise = nullptr;
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+        std::optional<std::string> await_resume();
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit GameLoop(std::coroutine_handle<promise_type> handle);
+    void resume(std::optional<std::string> line);
+
+public:
+    GameLoop(GameLoop&& other) noexcept;
+    GameLoop& operator=(GameLoop&& other) noexcept;
+    GameLoop(const GameLoop&) = delete;
+    GameLoop& operator=(const GameLoop&) = delete;
+    ~GameLoop();
+
+    // Output produced since the loop last suspended; valid until the next feed or close
+    std::string_view output() const;
+
+    // Resumes the loop with one input line, or with end of input
+    std::string_view feed(std::string_view line);
+    std::string_view close();
+
+    // True once the loop has co_returned
+    bool done() const;
+};
+
+// Coroutine version of Console::play; `game` must outlive the returned loop. A
+// resumed loop skips the welcome and first prompt, which the player has already seen
+GameLoop play_async(Game& game, bool resumed = false);
+
+#endif
@@ -0,0 +1,51 @@
+#include "History.h"
+
+// Constructor
+History::History(std::size_t max_turns) : max_turns(max_turns) {}
+
+// Recording
+void History::record(std::function<bool()> undo, std::function<bool()> redo) {
+    pending.push_back({std::move(undo), std::move(redo)});
+}
+
+void History::commit() {
+    if (pending.empty()) return;
+    done.push_back(std::move(pending));
+    pending.clear();
+    undone.clear();
+    if (done.size() > max_turns) done.pop_front();
+}
+
+// Time travel: a turn's changes are reverted in reverse order and reapplied in order. When a
+// change fails, the ones already stepped over are put back and the turn stays where it was
+History::Step History::undo() {
+    if (done.empty()) return Step::NOTHING;
+    std::vector<Change>& turn = done.back();
+    for (std::size_t i = turn.size(); i-- > 0;) {
+        if (turn[i].undo()) continue;
+        for (std::size_t j = i + 1; j < turn.size(); j++) turn[j].redo();
+        return Step::BLOCKED;
+    }
+    undone.push_back(std::move(turn));
+    done.pop_back();
+    return Step::DONE;
+}
+
+History::Step History::redo() {
+    if (undone.empty()) return Step::NOTHING;
+    std::vector<Change>& turn = undone.back();
+    for (std::size_t i = 0; i < turn.size(); i++) {
+        if (turn[i].redo()) continue;
+        for (std::size_t j = i; j-- > 0;) turn[j].undo();
+        return Step::BLOCKED;
+    }
+    done.push_back(std::move(turn));
+    undone.pop_back();
+    return Step::DONE;
+}
+
+void History::clear() {
+    pending.clear();
+    done.clear();
+    undone.clear();
+}
@@ -0,0 +1,44 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Journal of reversible changes, grouped into one turn per command. A change
+// returns false if the world no longer lets it happen (say, another player took
+// the Item back); the turn is then left as it was.
+class History {
+public:
+    enum class Step { NOTHING, DONE, BLOCKED };
+
+private:
+    struct Change {
+        std::function<bool()> undo;
+        std::function<bool()> redo;
+    };
+
+    std::vector<Change> pending;
+    std::deque<std::vector<Change>> done;
+    std::vector<std::vector<Change>> undone;
+    std::size_t max_turns;
+
+public:
+    // Constructor
+    explicit History(std::size_t max_turns = 1000);
+
+    // Records one change made by the current command
+    void record(std::function<bool()> undo, std::function<bool()> redo);
+
+    // Closes the current turn; a new turn discards anything that could be redone
+    void commit();
+
+    // Time travel; NOTHING if there is no turn to step over, BLOCKED if one of its changes failed
+    Step undo();
+    Step redo();
+
+    // Forgets every turn, e.g. when the changes they refer to no longer exist
+    void clear();
+};
+
+#endif
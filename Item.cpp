@@ -1,28 +1,39 @@
 #include "Item.h"
-#include <iostream>
-#include <sstream>
+#include <ostream>
+#include <charconv>
 
 // Constructor
-Item::Item(const std::string& name, const std::string& description, int calories, float weight) {
+Item::Item(const std::string& name, PackedText description, int calories, float weight) {
     if (name.empty()) throw std::invalid_argument("Name cannot be blank.");
     if (calories < 0 || calories > 1000) throw std::invalid_argument("Calories must be between 0 and 1000.");
     if (description.empty()) throw std::invalid_argument("Description cannot be blank.");
     if (weight < 0 || weight > 500) throw std::invalid_argument("Weight must be between 0 and 500.");
 
     this->name = name;
-    this->description = description;
+    this->description = std::move(description);
     this->calories = calories;
     this->weight = weight;
 }
 
 // Getters
 std::string Item::get_name() const {return name;}
-std::string Item::get_description() const { return description; }
+std::string Item::get_description() const { return description.str(); }
 int Item::get_calories() const { return calories; }
 float Item::get_weight() const { return weight; }
 
+void Item::pack(const std::shared_ptr<const TextDictionary>& dictionary) { description.pack(dictionary); }
+
+// Text form
+std::string Item::to_string() const {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), weight);
+    std::string text = name + "(" + std::to_string(calories) + " calories)- " + std::string(digits, result.ptr) + " lb- ";
+    description.append_to(text);
+    return text;
+}
+
 // Overloaded stream operator
 std::ostream& operator<<(std::ostream& os, const Item& item) {
-    os << item.name << "(" << item.calories << " calories)- " << item.weight << " lb- " << item.description;
+    os << item.to_string();
     return os;
 }
\ No newline at end of file
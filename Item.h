@@ -3,17 +3,18 @@
 
 #include <string>
 #include <stdexcept>
+#include "PackedText.h"
 
 class Item {
 private:
     std::string name;
-    std::string description;
+    PackedText description;
     int calories;
     float weight;
 
 public:
     // Constructor
-    Item(const std::string& name, const std::string& description, int calories, float weight);
+    Item(const std::string& name, PackedText description, int calories, float weight);
 
     // Getters
     std::string get_name() const;
@@ -21,6 +22,18 @@ public:
     int get_calories() const;
     float get_weight() const;
 
+    // Packs the description with a World's dictionary
+    void pack(const std::shared_ptr<const TextDictionary>& dictionary);
+
+    // Text form used by the game output
+    std::string to_string() const;
+
+    // Protocol serialization, dialogue scripts, search and storage read fields directly to avoid copies
+    friend class ProtocolWriter;
+    friend class DialogueScript;
+    friend class SearchIndex;
+    friend class EntityStore;
+
     // Overloaded stream operator
     friend std::ostream& operator<<(std::ostream& os, const Item& item);
 };
@@ -0,0 +1,217 @@
+#include "ItemIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+#include "World.h"
+
+// Constructors
+ItemIndex::ItemIndex() {
+    auto empty = std::make_shared<Columns>();
+    empty->location_offsets.assign(1, 0);
+    columns = std::move(empty);
+}
+
+/**
+ * @brief Snapshots the Items lying in the World into columns and sorts the indexes.
+ *
+ * The columns are copied straight from the World's entity store in one pass
+ * under its lock; Items in players' inventories are not included.
+ *
+ * @param world The World to index.
+ */
+ItemIndex::ItemIndex(const World& world) {
+    auto built = std::make_shared<Columns>();
+    Columns& c = *built;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    world.get_entities().for_each([&](std::uint32_t, std::int32_t owner, std::string_view name, int item_calories,
+                                      float weight) {
+        auto [found, inserted] = ids.try_emplace(name, static_cast<std::uint32_t>(c.names.size()));
+        if (inserted) c.names.emplace_back(name);
+        c.locations.push_back(static_cast<std::uint32_t>(owner));
+        c.calories.push_back(item_calories);
+        c.weights.push_back(weight);
+        c.name_ids.push_back(found->second);
+    });
+
+    // Group rows by Location with a counting sort
+    c.location_offsets.assign(world.get_locations().size() + 1, 0);
+    for (std::uint32_t location : c.locations) c.location_offsets[location + 1]++;
+    for (std::size_t i = 1; i < c.location_offsets.size(); i++) c.location_offsets[i] += c.location_offsets[i - 1];
+    c.location_rows.resize(c.locations.size());
+    std::vector<std::uint32_t> next(c.location_offsets.begin(), c.location_offsets.end() - 1);
+    for (std::uint32_t row = 0; row < c.locations.size(); row++) c.location_rows[next[c.locations[row]]++] = row;
+
+    std::vector<std::uint32_t> rows(c.locations.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    c.calories_rows = rows;
+    std::stable_sort(c.calories_rows.begin(), c.calories_rows.end(),
+                     [&c](std::uint32_t a, std::uint32_t b) { return c.calories[a] < c.calories[b]; });
+    c.weights_rows = std::move(rows);
+    std::stable_sort(c.weights_rows.begin(), c.weights_rows.end(),
+                     [&c](std::uint32_t a, std::uint32_t b) { return c.weights[a] < c.weights[b]; });
+    c.calories_sorted.reserve(c.locations.size());
+    c.weights_sorted.reserve(c.locations.size());
+    for (std::uint32_t row : c.calories_rows) c.calories_sorted.push_back(c.calories[row]);
+    for (std::uint32_t row : c.weights_rows) c.weights_sorted.push_back(c.weights[row]);
+    columns = std::move(built);
+}
+
+/**
+ * @brief Brings an index up to date without rebuilding its columns.
+ *
+ * Each changed Location's column rows are hidden and its current Items added
+ * after them; a Location changed more than once keeps only its latest Items.
+ * The cost is in the changed Locations' Items, not the World's.
+ *
+ * @param base The index to start from; its columns are shared.
+ * @param changes Changed Locations, oldest first.
+ */
+ItemIndex::ItemIndex(const ItemIndex& base, const std::vector<Change>& changes) : columns(base.columns) {
+    // The latest change to each Location wins
+    std::vector<const Change*> latest;
+    latest.reserve(changes.size());
+    for (const Change& change : changes) latest.push_back(&change);
+    std::stable_sort(latest.begin(), latest.end(),
+                     [](const Change* a, const Change* b) { return a->location < b->location; });
+    auto last = std::unique(latest.rbegin(), latest.rend(),
+                            [](const Change* a, const Change* b) { return a->location == b->location; });
+    latest.erase(latest.begin(), last.base());
+
+    std::vector<std::uint32_t> changed;
+    for (const Change* change : latest) changed.push_back(change->location);
+    std::set_union(base.replaced.begin(), base.replaced.end(), changed.begin(), changed.end(),
+                   std::back_inserter(replaced));
+
+    auto kept = base.added.begin();
+    for (const Change* change : latest) {
+        for (; kept != base.added.end() && kept->location < change->location; ++kept) added.push_back(*kept);
+        while (kept != base.added.end() && kept->location == change->location) ++kept;
+        for (const Item& item : change->items) {
+            added.push_back({change->location, item.get_name(), item.get_calories(), item.get_weight()});
+        }
+    }
+    added.insert(added.end(), kept, base.added.end());
+}
+
+/**
+ * @brief Finds the Items matching a filter.
+ *
+ * Three candidate sets are sized up front: the slice of the calorie column in
+ * range, the slice of the weight column in range (both by binary search), and
+ * the Items in Locations within reach (by breadth-first search over the exit
+ * graph). Only the smallest is walked; the other bounds are checked against the
+ * columns row by row. Rows of changed Locations are skipped in the columns and
+ * their current Items checked instead.
+ *
+ * @param filter The bounds to match.
+ * @param world The World the index was built from, for its exit graph.
+ * @return The matching rows; nearest first when the filter has a start.
+ */
+std::vector<ItemIndex::Match> ItemIndex::find(const Filter& filter, const World& world) const {
+    const Columns& c = *columns;
+    auto calories_begin = std::lower_bound(c.calories_sorted.begin(), c.calories_sorted.end(), filter.min_calories);
+    auto calories_end = std::upper_bound(calories_begin, c.calories_sorted.end(), filter.max_calories);
+    auto weights_begin = std::lower_bound(c.weights_sorted.begin(), c.weights_sorted.end(), filter.min_weight);
+    auto weights_end = std::upper_bound(weights_begin, c.weights_sorted.end(), filter.max_weight);
+    std::size_t by_calories = static_cast<std::size_t>(calories_end - calories_begin);
+    std::size_t by_weight = static_cast<std::size_t>(weights_end - weights_begin);
+
+    std::vector<std::uint32_t> reached;
+    std::vector<int> distances;
+    bool by_distance = filter.from_location >= 0;
+    std::size_t in_reach = SIZE_MAX;
+    if (by_distance) {
+        world.get_exit_graph().distances_from(static_cast<std::uint32_t>(filter.from_location), filter.max_moves,
+                                              reached, distances);
+        in_reach = 0;
+        for (std::uint32_t location : reached) {
+            in_reach += c.location_offsets[location + 1] - c.location_offsets[location];
+        }
+    }
+
+    std::vector<Match> matches;
+    auto check = [&](std::uint32_t row) {
+        int item_calories = get_calories(row);
+        float weight = get_weight(row);
+        if (item_calories < filter.min_calories || item_calories > filter.max_calories) return;
+        if (weight < filter.min_weight || weight > filter.max_weight) return;
+        int distance = by_distance ? distances[get_location(row)] : -1;
+        if (by_distance && distance < 0) return;
+        matches.push_back({row, distance});
+    };
+    const auto first_added = static_cast<std::uint32_t>(c.locations.size());
+
+    if (by_distance && in_reach <= by_calories && in_reach <= by_weight) {
+        for (std::uint32_t location : reached) {
+            if (is_replaced(location)) {
+                auto [begin, end] = added_in(location);
+                for (std::size_t i = begin; i < end; i++) check(first_added + static_cast<std::uint32_t>(i));
+                continue;
+            }
+            for (std::uint32_t i = c.location_offsets[location]; i < c.location_offsets[location + 1]; i++) {
+                check(c.location_rows[i]);
+            }
+        }
+        return matches;
+    }
+    auto check_current = [&](std::uint32_t row) {
+        if (replaced.empty() || !is_replaced(c.locations[row])) check(row);
+    };
+    if (by_calories <= by_weight) {
+        auto first = c.calories_rows.begin() + (calories_begin - c.calories_sorted.begin());
+        std::for_each(first, first + static_cast<std::ptrdiff_t>(by_calories), check_current);
+    } else {
+        auto first = c.weights_rows.begin() + (weights_begin - c.weights_sorted.begin());
+        std::for_each(first, first + static_cast<std::ptrdiff_t>(by_weight), check_current);
+    }
+    for (std::size_t i = 0; i < added.size(); i++) check(first_added + static_cast<std::uint32_t>(i));
+    if (by_distance) {
+        std::stable_sort(matches.begin(), matches.end(),
+                         [](const Match& a, const Match& b) { return a.distance < b.distance; });
+    }
+    return matches;
+}
+
+// Helper methods
+bool ItemIndex::is_replaced(std::uint32_t location) const {
+    return std::binary_search(replaced.begin(), replaced.end(), location);
+}
+
+std::pair<std::size_t, std::size_t> ItemIndex::added_in(std::uint32_t location) const {
+    auto [begin, end] = std::equal_range(added.begin(), added.end(), Added{location, {}, 0, 0.0F},
+                                         [](const Added& a, const Added& b) { return a.location < b.location; });
+    return {static_cast<std::size_t>(begin - added.begin()), static_cast<std::size_t>(end - added.begin())};
+}
+
+// Row access; rows past the columns are Items of changed Locations
+std::size_t ItemIndex::size() const {
+    const Columns& c = *columns;
+    std::size_t hidden = 0;
+    for (std::uint32_t location : replaced) hidden += c.location_offsets[location + 1] - c.location_offsets[location];
+    return c.locations.size() - hidden + added.size();
+}
+
+const std::string& ItemIndex::get_name(std::uint32_t row) const {
+    if (row >= columns->locations.size()) return added[row - columns->locations.size()].name;
+    return columns->names[columns->name_ids[row]];
+}
+
+int ItemIndex::get_calories(std::uint32_t row) const {
+    if (row >= columns->locations.size()) return added[row - columns->locations.size()].calories;
+    return columns->calories[row];
+}
+
+float ItemIndex::get_weight(std::uint32_t row) const {
+    if (row >= columns->locations.size()) return added[row - columns->locations.size()].weight;
+    return columns->weights[row];
+}
+
+std::uint32_t ItemIndex::get_location(std::uint32_t row) const {
+    if (row >= columns->locations.size()) return added[row - columns->locations.size()].location;
+    return columns->locations[row];
+}
+
+// Overlay
+std::size_t ItemIndex::change_count() const { return replaced.size(); }
+std::size_t ItemIndex::column_size() const { return columns->locations.size(); }
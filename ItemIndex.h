@@ -0,0 +1,98 @@
+#ifndef ITEMINDEX_H
+#define ITEMINDEX_H
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Item.h"
+
+class World;
+
+// Columnar snapshot of the Items lying around a World, with secondary indexes
+// for attribute queries: calories and weight are each kept as a sorted column
+// (values plus row numbers), and rows are grouped by Location. Locations whose
+// Items changed since the snapshot are overlaid with their current Items, so
+// the index can be brought up to date without rebuilding the columns, which
+// are shared with the indexes made from it.
+class ItemIndex {
+public:
+    // Bounds are inclusive; a start Location and a move limit restrict by distance
+    struct Filter {
+        int min_calories = std::numeric_limits<int>::min();
+        int max_calories = std::numeric_limits<int>::max();
+        float min_weight = -std::numeric_limits<float>::infinity();
+        float max_weight = std::numeric_limits<float>::infinity();
+        int from_location = -1;
+        int max_moves = -1;
+    };
+
+    struct Match {
+        std::uint32_t row;
+        int distance;
+    };
+
+    // The Items lying in a Location after a change
+    struct Change {
+        std::uint32_t location;
+        std::vector<Item> items;
+    };
+
+private:
+    struct Columns {
+        // One row per Item
+        std::vector<std::uint32_t> locations;
+        std::vector<int> calories;
+        std::vector<float> weights;
+        std::vector<std::uint32_t> name_ids;
+        std::vector<std::string> names;
+
+        // Secondary indexes
+        std::vector<int> calories_sorted;
+        std::vector<std::uint32_t> calories_rows;
+        std::vector<float> weights_sorted;
+        std::vector<std::uint32_t> weights_rows;
+        std::vector<std::uint32_t> location_offsets;
+        std::vector<std::uint32_t> location_rows;
+    };
+
+    // An Item from a Change; these are numbered after the columns' rows
+    struct Added {
+        std::uint32_t location;
+        std::string name;
+        int calories;
+        float weight;
+    };
+
+    std::shared_ptr<const Columns> columns;
+    std::vector<std::uint32_t> replaced;   // Locations whose column rows are out of date, sorted
+    std::vector<Added> added;              // their current Items, sorted by Location
+
+    // Helper methods
+    bool is_replaced(std::uint32_t location) const;
+    std::pair<std::size_t, std::size_t> added_in(std::uint32_t location) const;
+
+public:
+    // Constructors; the second snapshots the World's Items, the third is `base` with
+    // `changes` (oldest first) laid over it
+    ItemIndex();
+    explicit ItemIndex(const World& world);
+    ItemIndex(const ItemIndex& base, const std::vector<Change>& changes);
+
+    // Items matching every bound, nearest first when a start is given
+    std::vector<Match> find(const Filter& filter, const World& world) const;
+
+    // Row access
+    std::size_t size() const;
+    const std::string& get_name(std::uint32_t row) const;
+    int get_calories(std::uint32_t row) const;
+    float get_weight(std::uint32_t row) const;
+    std::uint32_t get_location(std::uint32_t row) const;
+
+    // Locations overlaid since the columns were built, and the rows in the columns
+    std::size_t change_count() const;
+    std::size_t column_size() const;
+};
+
+#endif
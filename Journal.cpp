@@ -0,0 +1,503 @@
+/**
+ * @file Journal.cpp
+ * @brief Write-ahead session log with group commit, snapshots and recovery.
+ *
+ * The directory holds numbered log segments and snapshots. snapshot-N holds
+ * the state as of the start of log-N, so recovery loads the newest snapshot and
+ * replays every log segment from the same number on. Both are sequences of
+ * records:
+ *
+ *   u32 size   u32 crc32 of the rest   u8 kind   u64 session token   i64 time (ms)   payload
+ *
+ * A record whose size or checksum does not add up ends the file: it was being
+ * written when the server went down. Snapshots are written to a temporary name
+ * and renamed into place, and older files are deleted only after that.
+ *
+ * Autosave never stops commits for long: the journal thread starts the new
+ * segment and takes the snapshot's view in one step, which only copies 64
+ * shard pointers; the autosave thread then writes the view out at its own pace.
+ * The first change to a shard after that copies the shard, so the view stays
+ * exactly as it was taken.
+ *
+ * Sessions nobody has played for `session_ttl` are dropped when a segment
+ * starts, including those cut off without their game ending. Each gets an END
+ * record at the start of the new segment, so a recovery that has to fall back
+ * to an older snapshot drops them as well.
+ */
+
+#include "Journal.h"
+#include "Bytes.h"
+#include <fcntl.h>
+#include <sys/random.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <vector>
+#include <system_error>
+
+namespace {
+    std::system_error os_error(const char* what) { return std::system_error(errno, std::generic_category(), what); }
+
+    constexpr std::array<std::uint32_t, 256> crc_table() {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<std::uint32_t, 256> CRC_TABLE = crc_table();
+
+    // Running CRC-32; start from 0xFFFFFFFF and invert the result
+    std::uint32_t crc32(std::uint32_t crc, std::string_view data) {
+        for (unsigned char byte : data) crc = CRC_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    std::int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void write_all(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t written = write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw os_error("write journal");
+            }
+            data.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+
+    std::uint64_t random_u64() {
+        std::uint64_t value = 0;
+        auto* out = reinterpret_cast<char*>(&value);
+        std::size_t filled = 0;
+        while (filled < sizeof(value)) {
+            ssize_t got = getrandom(out + filled, sizeof(value) - filled, 0);
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw os_error("getrandom");
+            }
+            filled += static_cast<std::size_t>(got);
+        }
+        return value;
+    }
+
+    std::string read_file(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // "log-12" -> 12 for the given prefix, or nothing
+    std::optional<std::uint64_t> numbered(const std::string& name, std::string_view prefix) {
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) return std::nullopt;
+        if (!std::all_of(name.begin() + static_cast<std::ptrdiff_t>(prefix.size()), name.end(),
+                         [](char c) { return c >= '0' && c <= '9'; })) {
+            return std::nullopt;
+        }
+        return std::stoull(name.substr(prefix.size()));
+    }
+}
+
+// Constructor
+Journal::Journal(Options options)
+    : options(std::move(options)), log_fd(-1), segment(0), segment_bytes(0), torn(false), stopping(false), in_snapshot{},
+      snapshot_wanted(false), capture_requested(false) {
+    for (auto& shard : shards) shard = std::make_shared<Shard>();
+    std::filesystem::create_directories(this->options.directory);
+    recover();
+    write_snapshot(begin_segment(), false);
+}
+
+// An autosave in progress is abandoned; the log it would have replaced is still there
+Journal::~Journal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    autosave_wake.notify_one();
+    captured_ready.notify_one();
+    if (autosave.joinable()) autosave.join();
+    if (thread.joinable()) thread.join();
+    if (log_fd >= 0) close(log_fd);
+}
+
+std::string Journal::path(const char* kind, std::uint64_t number) const {
+    return options.directory + "/" + kind + "-" + std::to_string(number);
+}
+
+/**
+ * @brief Rebuilds the latest state from the newest snapshot and the log after it.
+ *
+ * Every recovered session is detached, so its player can resume it.
+ */
+void Journal::recover() {
+    std::set<std::uint64_t> snapshots;
+    std::set<std::uint64_t> logs;
+    for (const auto& file : std::filesystem::directory_iterator(options.directory)) {
+        std::string name = file.path().filename().string();
+        if (auto number = numbered(name, "snapshot-")) snapshots.insert(*number);
+        else if (auto number = numbered(name, "log-")) logs.insert(*number);
+    }
+    std::uint64_t base = snapshots.empty() ? 0 : *snapshots.rbegin();
+    if (base > 0) apply(read_file(path("snapshot", base)));
+    for (auto number = logs.lower_bound(base); number != logs.end(); ++number) apply(read_file(path("log", *number)));
+    segment = std::max(base, logs.empty() ? 0 : *logs.rbegin());
+    for (const auto& shard : shards) {
+        for (const auto& [token, saved] : *shard) detached.emplace(token, saved);
+    }
+}
+
+/**
+ * @brief Folds records into the latest state.
+ *
+ * @param records Encoded records, as in a log segment or snapshot.
+ * @return How many bytes were valid records; the rest is a torn write.
+ */
+std::size_t Journal::apply(std::string_view records) {
+    std::size_t offset = 0;
+    while (records.size() - offset >= HEADER) {
+        ByteReader sizes(records.substr(offset, HEADER), "Journal record is corrupt.");
+        auto size = sizes.get<std::uint32_t>();
+        auto crc = sizes.get<std::uint32_t>();
+        if (records.size() - offset - HEADER < size) break;
+        std::string_view body = records.substr(offset + HEADER, size);
+        if (~crc32(0xFFFFFFFF, body) != crc) break;
+        try {
+            ByteReader reader(body, "Journal record is corrupt.");
+            auto kind = reader.get<std::uint8_t>();
+            auto token = reader.get<std::uint64_t>();
+            auto time = reader.get<std::int64_t>();
+            std::string_view payload = body.substr(FIELDS);
+            if (kind == SESSION) writable(token)[token] = Saved{time, std::string(payload)};
+            else if (kind == END) writable(token).erase(token);
+            else if (kind == WORLD) world = Saved{time, std::string(payload)};
+        } catch (const std::invalid_argument&) {
+            break;
+        }
+        offset += HEADER + size;
+    }
+    return offset;
+}
+
+// Everything but the payload; the checksum is computed here, outside any lock
+Journal::Header Journal::header(Kind kind, std::uint64_t token, std::int64_t time, std::string_view payload) {
+    Header head;
+    char* fields = head.data() + HEADER;
+    fields[0] = static_cast<char>(kind);
+    std::memcpy(fields + 1, &token, sizeof(token));
+    std::memcpy(fields + 1 + sizeof(token), &time, sizeof(time));
+    auto size = static_cast<std::uint32_t>(head.size() - HEADER + payload.size());
+    std::uint32_t crc = ~crc32(crc32(0xFFFFFFFF, std::string_view(fields, head.size() - HEADER)), payload);
+    std::memcpy(head.data(), &size, sizeof(size));
+    std::memcpy(head.data() + sizeof(size), &crc, sizeof(crc));
+    return head;
+}
+
+void Journal::encode(std::string& out, Kind kind, std::uint64_t token, std::int64_t time, std::string_view payload) {
+    Header head = header(kind, token, time, payload);
+    out.append(head.data(), head.size());
+    out.append(payload);
+}
+
+// The shard holding `token`, copied first if a snapshot still shares it
+Journal::Shard& Journal::writable(std::uint64_t token) {
+    std::size_t index = token % SHARDS;
+    if (in_snapshot[index]) {
+        shards[index] = std::make_shared<Shard>(*shards[index]);
+        in_snapshot[index] = false;
+    }
+    return *shards[index];
+}
+
+// Drops sessions not played since the TTL, before the new segment's snapshot is taken
+void Journal::expire() {
+    if (options.session_ttl.count() == 0) return;
+    std::int64_t now = now_ms();
+    std::int64_t cutoff = now - std::chrono::duration_cast<std::chrono::milliseconds>(options.session_ttl).count();
+    std::vector<std::uint64_t> expired;
+    for (const auto& shard : shards) {
+        for (const auto& [token, saved] : *shard) {
+            if (saved.time < cutoff) expired.push_back(token);
+        }
+    }
+    std::string ends;
+    for (std::uint64_t token : expired) {
+        writable(token).erase(token);
+        encode(ends, END, token, now, {});
+    }
+    // Written unsynced; if they are lost, the next start expires the sessions again
+    write_log(ends, false);
+
+    std::lock_guard<std::mutex> lock(detached_mutex);
+    for (std::uint64_t token : expired) detached.erase(token);
+    std::erase_if(detached, [cutoff](const auto& entry) { return entry.second.time < cutoff; });
+}
+
+void Journal::open_segment() {
+    int fd = open(path("log", segment + 1).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) throw os_error("open journal");
+    if (log_fd >= 0) close(log_fd);
+    log_fd = fd;
+    segment++;
+    segment_bytes = 0;
+    torn = false;
+}
+
+/**
+ * @brief Appends records to the current segment.
+ *
+ * Recovery stops reading a segment at the first torn record, so a write (or
+ * sync) that fails is cut back off the file before anything else is appended.
+ * If even that fails, the next records go to a new segment instead, which
+ * recovery reads after this one.
+ *
+ * @param records Encoded records.
+ * @param sync Whether to wait for them to reach the disk.
+ * @throws std::system_error If the records could not be written; none of them count.
+ */
+void Journal::write_log(std::string_view records, bool sync) {
+    if (torn) open_segment();
+    try {
+        write_all(log_fd, records);
+        if (sync && fdatasync(log_fd) < 0) throw os_error("fdatasync journal");
+    } catch (const std::system_error&) {
+        if (ftruncate(log_fd, static_cast<off_t>(segment_bytes)) < 0) torn = true;
+        throw;
+    }
+    segment_bytes += records.size();
+}
+
+/**
+ * @brief Starts the next log segment and takes a view of the state it starts from.
+ *
+ * The new segment exists before its snapshot does, so a crash before the
+ * snapshot is complete still recovers from the previous snapshot and replays
+ * both segments. Expired sessions are dropped first.
+ *
+ * @return The view, to be written by write_snapshot.
+ */
+Journal::Snapshot Journal::begin_segment() {
+    open_segment();
+    expire();
+
+    Snapshot snapshot{segment, {}, world};
+    std::copy(shards.begin(), shards.end(), snapshot.shards.begin());
+    in_snapshot.fill(true);
+    return snapshot;
+}
+
+/**
+ * @brief Writes a snapshot, then deletes the files it replaces.
+ *
+ * A throttled write goes out in chunks paced to `autosave_rate`, so a large
+ * snapshot does not starve the log's fsyncs of disk bandwidth, and gives up
+ * if the journal is stopping.
+ *
+ * @param snapshot A view from begin_segment.
+ * @param throttled True on the autosave thread.
+ */
+void Journal::write_snapshot(const Snapshot& snapshot, bool throttled) {
+    std::string temporary = path("snapshot", snapshot.segment) + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) throw os_error("open snapshot");
+    auto started = std::chrono::steady_clock::now();
+    std::uint64_t written = 0;
+    std::string chunk;
+    auto flush = [&] {
+        write_all(fd, chunk);
+        written += chunk.size();
+        chunk.clear();
+        if (!throttled || options.autosave_rate == 0) return true;
+        auto due = started + std::chrono::microseconds(written * 1000000 / options.autosave_rate);
+        std::unique_lock<std::mutex> lock(mutex);
+        return !autosave_wake.wait_until(lock, due, [this] { return stopping; });
+    };
+    bool complete = true;
+    try {
+        for (const auto& shard : snapshot.shards) {
+            for (const auto& [token, saved] : *shard) {
+                encode(chunk, SESSION, token, saved.time, saved.bytes);
+                if (chunk.size() >= CHUNK && !(complete = flush())) break;
+            }
+            if (!complete) break;
+        }
+        if (complete && snapshot.world) encode(chunk, WORLD, 0, snapshot.world->time, snapshot.world->bytes);
+        if (complete) write_all(fd, chunk);
+        if (complete && fsync(fd) < 0) throw os_error("fsync snapshot");
+    } catch (...) {
+        close(fd);
+        std::filesystem::remove(temporary);
+        throw;
+    }
+    close(fd);
+    if (!complete) {
+        std::filesystem::remove(temporary);
+        return;
+    }
+    std::filesystem::rename(temporary, path("snapshot", snapshot.segment));
+    int directory_fd = open(options.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory_fd >= 0) {
+        fsync(directory_fd);
+        close(directory_fd);
+    }
+
+    for (const auto& file : std::filesystem::directory_iterator(options.directory)) {
+        std::string name = file.path().filename().string();
+        auto number = numbered(name, "snapshot-");
+        if (!number) number = numbered(name, "log-");
+        if (number && *number < snapshot.segment) std::filesystem::remove(file.path());
+        else if (!number && name.ends_with(".tmp") && !throttled) std::filesystem::remove(file.path());
+    }
+}
+
+bool Journal::restore_world(World& shared) const {
+    if (!world) return false;
+    shared.restore_progress(world->bytes, std::chrono::milliseconds(now_ms() - world->time));
+    return true;
+}
+
+void Journal::start(Progress progress) {
+    this->progress = std::move(progress);
+    thread = std::thread([this] { run(); });
+    autosave = std::thread([this] { run_autosave(); });
+}
+
+/**
+ * @brief The journal thread: gathers records, then writes and syncs them as one commit.
+ *
+ * Waiting `commit_interval` after the first record of a batch lets the other
+ * sessions' records share its fsync. A commit that fails is reported and
+ * dropped, and cut back off the log so later commits still recover; the
+ * sessions keep playing without durability until the disk recovers.
+ * When the autosave thread asks for a snapshot, the batch is committed first
+ * and the new segment starts right after it, so the view matches the log.
+ */
+void Journal::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || capture_requested || !pending.empty(); });
+        if (!stopping && !capture_requested) {
+            wake.wait_for(lock, options.commit_interval, [this] { return stopping || capture_requested; });
+        }
+        writing.swap(pending);
+        bool capture = capture_requested && !stopping;
+        bool last = stopping;
+        lock.unlock();
+        std::optional<Snapshot> snapshot;
+        try {
+            commit();
+            // Nothing new since the last snapshot: it is still current
+            if (capture && segment_bytes > 0) snapshot = begin_segment();
+        } catch (const std::exception& error) {
+            std::cerr << "Journal commit failed: " << error.what() << "\n";
+        }
+        writing.clear();
+        lock.lock();
+        if (capture) {
+            captured = std::move(snapshot);
+            capture_requested = false;
+            captured_ready.notify_one();
+        }
+        if (last && pending.empty()) return;
+    }
+}
+
+/**
+ * @brief The autosave thread: writes a snapshot every `autosave_interval`, or
+ * sooner once the log segment has grown past `segment_size`.
+ */
+void Journal::run_autosave() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        auto due = [this] { return stopping || snapshot_wanted; };
+        if (options.autosave_interval.count() > 0) autosave_wake.wait_for(lock, options.autosave_interval, due);
+        else autosave_wake.wait(lock, due);
+        if (stopping) return;
+        snapshot_wanted = false;
+        capture_requested = true;
+        wake.notify_one();
+        captured_ready.wait(lock, [this] { return stopping || !capture_requested; });
+        if (capture_requested) return;
+        std::optional<Snapshot> snapshot = std::move(captured);
+        captured.reset();
+        if (!snapshot) continue;
+        lock.unlock();
+        try {
+            write_snapshot(*snapshot, true);
+        } catch (const std::exception& error) {
+            std::cerr << "Journal autosave failed: " << error.what() << "\n";
+        }
+        snapshot.reset();
+        lock.lock();
+    }
+}
+
+void Journal::commit() {
+    if (progress) {
+        world_bytes.clear();
+        progress(world_bytes);
+        if (!world || world->bytes != world_bytes) encode(writing, WORLD, 0, now_ms(), world_bytes);
+    }
+    if (writing.empty()) return;
+    bool was_due = segment_bytes >= options.segment_size;
+    write_log(writing, true);
+    apply(writing);
+    if (!was_due && segment_bytes >= options.segment_size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot_wanted = true;
+        autosave_wake.notify_one();
+    }
+}
+
+// Records
+void Journal::append(Kind kind, std::uint64_t token, std::string_view payload) {
+    Header head = header(kind, token, now_ms(), payload);
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        first = pending.empty();
+        pending.append(head.data(), head.size());
+        pending.append(payload);
+    }
+    if (first) wake.notify_one();
+}
+
+void Journal::record(std::uint64_t token, std::string_view saved) { append(SESSION, token, saved); }
+void Journal::end(std::uint64_t token) { append(END, token, {}); }
+
+// Resuming
+std::uint64_t Journal::new_token() {
+    std::lock_guard<std::mutex> lock(detached_mutex);
+    std::uint64_t token;
+    do {
+        token = random_u64();
+    } while (token == 0 || detached.count(token));
+    return token;
+}
+
+void Journal::detach(std::uint64_t token, std::string saved) {
+    std::lock_guard<std::mutex> lock(detached_mutex);
+    detached[token] = Saved{now_ms(), std::move(saved)};
+}
+
+std::optional<std::string> Journal::resume(std::uint64_t token) {
+    std::lock_guard<std::mutex> lock(detached_mutex);
+    auto found = detached.find(token);
+    if (found == detached.end()) return std::nullopt;
+    std::string saved = std::move(found->second.bytes);
+    detached.erase(found);
+    return saved;
+}
@@ -0,0 +1,147 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "World.h"
+
+// Write-ahead log that lets sessions survive a server crash or restart. After
+// each command that changes a session, its connection records the session's
+// saved form; records from every reactor are gathered for a short interval
+// and written with one fsync (group commit) by the journal's own thread, so a
+// command only pays for copying its record into a buffer. The log is split
+// into segments, and a snapshot of every session's latest state starts each
+// new segment; recovery loads the newest snapshot and replays the log after it.
+// Snapshots (autosaves) are written by a second thread from a copy-on-write
+// view of that state, at a bounded rate, while commits carry on.
+class Journal {
+public:
+    struct Options {
+        std::string directory;
+        std::chrono::microseconds commit_interval{1000};   // how long a commit waits for more records to join it
+        std::uint64_t segment_size = 16 << 20;             // log bytes written before the next snapshot is due
+        std::chrono::seconds autosave_interval{60};        // time between snapshots; 0 for only by segment size
+        std::uint64_t autosave_rate = 32 << 20;            // snapshot bytes written per second; 0 for no limit
+        std::chrono::seconds session_ttl{24 * 60 * 60};    // how long an unplayed session stays resumable; 0 for ever
+    };
+
+    // Writes the shared World's progress; polled by the journal thread at each commit
+    using Progress = std::function<void(std::string& out)>;
+
+private:
+    enum Kind : std::uint8_t { SESSION = 1, END, WORLD };
+
+    // A record's size and checksum, then its kind, token and time
+    static constexpr std::size_t HEADER = 2 * sizeof(std::uint32_t);
+    static constexpr std::size_t FIELDS = 1 + sizeof(std::uint64_t) + sizeof(std::int64_t);
+    using Header = std::array<char, HEADER + FIELDS>;
+
+    // State is sharded so a snapshot can share it and a change copies only one shard
+    static constexpr std::size_t SHARDS = 64;
+    static constexpr std::size_t CHUNK = 256 * 1024;
+
+    struct Saved {
+        std::int64_t time;   // milliseconds since the epoch
+        std::string bytes;
+    };
+
+    using Shard = std::unordered_map<std::uint64_t, Saved>;
+
+    // The state as of the start of a segment; shards are never changed once shared with a snapshot
+    struct Snapshot {
+        std::uint64_t segment;
+        std::array<std::shared_ptr<const Shard>, SHARDS> shards;
+        std::optional<Saved> world;
+    };
+
+    Options options;
+    int log_fd;
+    std::uint64_t segment;
+    std::uint64_t segment_bytes;   // the segment's length; a failed write is cut back to it
+    bool torn;                     // cutting back failed, so the next write starts a new segment
+
+    // Records waiting for the next commit
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::string pending;
+    bool stopping;
+
+    // The latest state of every session and of the shared World; owned by the journal thread once started
+    std::array<std::shared_ptr<Shard>, SHARDS> shards;
+    std::array<bool, SHARDS> in_snapshot;
+    std::optional<Saved> world;
+    Progress progress;
+    std::string writing;
+    std::string world_bytes;
+    std::thread thread;
+
+    // Autosave: the journal thread captures a Snapshot at a segment boundary when asked, the
+    // autosave thread writes it; both hand-offs go through `mutex`
+    std::condition_variable autosave_wake;
+    std::condition_variable captured_ready;
+    bool snapshot_wanted;
+    bool capture_requested;
+    std::optional<Snapshot> captured;
+    std::thread autosave;
+
+    // Sessions recovered from disk or cut off from their connection, waiting to be resumed;
+    // the time is when the session was last played
+    std::mutex detached_mutex;
+    std::unordered_map<std::uint64_t, Saved> detached;
+
+    // Helper methods
+    std::string path(const char* kind, std::uint64_t number) const;
+    void recover();
+    std::size_t apply(std::string_view records);
+    Shard& writable(std::uint64_t token);
+    void expire();
+    void open_segment();
+    void write_log(std::string_view records, bool sync);
+    Snapshot begin_segment();
+    void write_snapshot(const Snapshot& snapshot, bool throttled);
+    void commit();
+    void run();
+    void run_autosave();
+    void append(Kind kind, std::uint64_t token, std::string_view payload);
+    static Header header(Kind kind, std::uint64_t token, std::int64_t time, std::string_view payload);
+    static void encode(std::string& out, Kind kind, std::uint64_t token, std::int64_t time, std::string_view payload);
+
+public:
+    // Constructor; recovers what the directory holds (creating it if needed) and starts a
+    // fresh segment. Throws std::system_error if the directory cannot be used
+    explicit Journal(Options options);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Gives a freshly built shared World its recovered progress; false if there was none
+    bool restore_world(World& world) const;
+
+    // Starts committing and autosaving; `progress` may be empty when there is no shared World
+    void start(Progress progress);
+
+    // Session records, from any thread: the latest saved form, and the end of the game
+    void record(std::uint64_t token, std::string_view saved);
+    void end(std::uint64_t token);
+
+    // Resuming: a new token for a new session, a session whose connection went away,
+    // and taking such a session over; resume returns nothing for unknown tokens. Tokens
+    // come from the kernel's CSPRNG, since knowing one is all it takes to take a session
+    // over; new_token throws std::system_error if the kernel cannot supply one
+    std::uint64_t new_token();
+    void detach(std::uint64_t token, std::string saved);
+    std::optional<std::string> resume(std::uint64_t token);
+};
+
+#endif
@@ -1,9 +1,34 @@
 #include "Location.h"
-#include <iostream>
+#include <ostream>
+#include <algorithm>
+#include <stdexcept>
 
 // Constructor
-Location::Location(const std::string& name, const std::string& description)
-    : name(name), description(description), visited(false) {}
+Location::Location(const std::string& name, PackedText description)
+    : name(name), description(std::move(description)), visited(false), entities(nullptr), id(EntityStore::NOWHERE) {}
+
+// Moving keeps the Item rows; copying would have two Locations owning them
+Location::Location(Location&& other) noexcept
+    : name(std::move(other.name)), description(std::move(other.description)), visited(other.visited.load()),
+      neighbors(std::move(other.neighbors)), npcs(std::move(other.npcs)), entities(other.entities), id(other.id),
+      items(std::move(other.items)) {}
+
+Location& Location::operator=(Location&& other) noexcept {
+    name = std::move(other.name);
+    description = std::move(other.description);
+    visited = other.visited.load();
+    neighbors = std::move(other.neighbors);
+    npcs = std::move(other.npcs);
+    entities = other.entities;
+    id = other.id;
+    items = std::move(other.items);
+    return *this;
+}
+
+void Location::attach(EntityStore* entities, std::int32_t id) {
+    this->entities = entities;
+    this->id = id;
+}
 
 // Neighbor management
 void Location::add_location(const std::string& direction, Location* location) {
@@ -17,34 +42,82 @@ std::map<std::string, Location*> Location::get_locations() const { return neighb
 // NPC management
 void Location::add_npc(const NPC& npc) { npcs.push_back(npc); }
 std::vector<NPC> Location::get_npcs() const { return npcs; }
+NPC* Location::find_npc(const std::string& name) {
+    auto it = std::find_if(npcs.begin(), npcs.end(), [&name](const NPC& n) { return n.get_name() == name; });
+    return it == npcs.end() ? nullptr : &*it;
+}
+std::optional<NPC> Location::remove_npc(const std::string& name) {
+    auto it = std::find_if(npcs.begin(), npcs.end(), [&name](const NPC& n) { return n.get_name() == name; });
+    if (it == npcs.end()) return std::nullopt;
+    NPC npc = *it;
+    npcs.erase(it);
+    return npc;
+}
 
 // Item management
-void Location::add_item(const Item& item) { items.push_back(item); }
-std::vector<Item> Location::get_items() const { return items; }
+void Location::add_item(const Item& item) {
+    if (entities == nullptr) throw std::logic_error("Location is not part of a World.");
+    items.push_back(entities->add(item, id));
+}
+
+std::vector<Item> Location::get_items() const {
+    std::vector<Item> result;
+    result.reserve(items.size());
+    for (std::uint32_t row : items) result.push_back(entities->get(row));
+    return result;
+}
+
+std::optional<Item> Location::find_item(const std::string& name) const {
+    for (std::uint32_t row : items) {
+        if (entities->is_named(row, name)) return entities->get(row);
+    }
+    return std::nullopt;
+}
+
+// False if no Item by that name is here
+bool Location::remove_item(const std::string& name) {
+    auto it = std::find_if(items.begin(), items.end(), [&](std::uint32_t row) { return entities->is_named(row, name); });
+    if (it == items.end()) return false;
+    entities->remove(*it);
+    items.erase(it);
+    return true;
+}
+
+const std::vector<std::uint32_t>& Location::get_item_rows() const { return items; }
 
 // Visited status
 void Location::set_visited() { visited = true; }
+void Location::reset_visited() { visited = false; }
 bool Location::get_visited() const { return visited; }
 
 //getter
 std::string Location::get_name() const { return name; }
+std::string Location::get_description() const { return description.str(); }
 
-// Overloaded stream operator
-std::ostream& operator<<(std::ostream& os, const Location& location) {
-    os << location.name << "- " << location.description << "\n";
-    os << "You see the following NPCs: ";
-    if (location.npcs.empty()) os << "None\n";
+// Text form
+std::string Location::to_string() const {
+    std::string text = name + "- ";
+    description.append_to(text);
+    text += "\n";
+    text += "You see the following NPCs: ";
+    if (npcs.empty()) text += "None\n";
     else {
-        for (const auto& npc : location.npcs) os << "- " << npc.get_name() << "\n";
+        for (const auto& npc : npcs) text += "- " + npc.get_name() + "\n";
     }
-    os << "You see the following Items: ";
-    if (location.items.empty()) os << "None\n";
+    text += "You see the following Items: ";
+    if (items.empty()) text += "None\n";
     else {
-        for (const auto& item : location.items) os << "- " << item << "\n";
+        for (const auto& item : get_items()) text += "- " + item.to_string() + "\n";
     }
-    os << "You can go in the following Directions:\n";
-    for (const auto& [dir, loc] : location.neighbors) {
-        os << "- " << dir << "- " << loc->get_name() << (loc->get_visited() ? " (Visited)" : " (Unknown)") << "\n";
+    text += "You can go in the following Directions:\n";
+    for (const auto& [dir, loc] : neighbors) {
+        text += "- " + dir + "- " + loc->get_name() + (loc->get_visited() ? " (Visited)" : " (Unknown)") + "\n";
     }
+    return text;
+}
+
+// Overloaded stream operator
+std::ostream& operator<<(std::ostream& os, const Location& location) {
+    os << location.to_string();
     return os;
 }
\ No newline at end of file
@@ -4,21 +4,32 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include "EntityStore.h"
 #include "Item.h"
 #include "NPC.h"
 
 class Location {
 private:
     std::string name;
-    std::string description;
-    bool visited;
+    PackedText description;
+    std::atomic<bool> visited;   // read for neighbors without holding their lock
     std::map<std::string, Location*> neighbors;
     std::vector<NPC> npcs;
-    std::vector<Item> items;
+    EntityStore* entities;       // where this Location's Items are stored, set by its World
+    std::int32_t id;
+    std::vector<std::uint32_t> items;
 
 public:
     // Constructor
-    Location(const std::string& name, const std::string& description);
+    Location(const std::string& name, PackedText description);
+    Location(Location&& other) noexcept;
+    Location& operator=(Location&& other) noexcept;
+
+    // Joins a World: Items added from now on are stored in its entity store under `id`
+    void attach(EntityStore* entities, std::int32_t id);
 
     // Neighbor management
     void add_location(const std::string& direction, Location* location);
@@ -27,17 +38,31 @@ public:
     // NPC management
     void add_npc(const NPC& npc);
     std::vector<NPC> get_npcs() const;
+    std::optional<NPC> remove_npc(const std::string& name);
+    NPC* find_npc(const std::string& name);
 
     // Item management
     void add_item(const Item& item);
     std::vector<Item> get_items() const;
+    std::optional<Item> find_item(const std::string& name) const;
+    bool remove_item(const std::string& name);
+    const std::vector<std::uint32_t>& get_item_rows() const;
 
     // Visited status
     void set_visited();
+    void reset_visited();
     bool get_visited() const;
 
     // Name getter
     std::string get_name() const;
+    std::string get_description() const;
+
+    // Text form used by the game output
+    std::string to_string() const;
+
+    // Protocol serialization and search read fields directly to avoid copies
+    friend class ProtocolWriter;
+    friend class SearchIndex;
 
     // Overloaded stream operator
     friend std::ostream& operator<<(std::ostream& os, const Location& location);
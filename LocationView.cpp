@@ -0,0 +1,49 @@
+#include "LocationView.h"
+#include <algorithm>
+#include <iterator>
+
+// Constructors
+LocationView::LocationView() = default;
+
+LocationView::LocationView(const Location& location) : name(location.get_name()), items(location.get_items()) {
+    for (const auto& npc : location.get_npcs()) npcs.push_back(npc.get_name());
+    for (const auto& [dir, loc] : location.get_locations()) exits[dir] = {loc->get_name(), loc->get_visited()};
+    std::sort(items.begin(), items.end(),
+              [](const Item& a, const Item& b) { return a.get_name() < b.get_name(); });
+    std::sort(npcs.begin(), npcs.end());
+}
+
+bool LocationView::empty() const { return name.empty(); }
+
+// Diff output
+bool LocationView::write_diff(std::string& out, const LocationView& previous) const {
+    if (previous.empty() || previous.name != name) return false;
+
+    auto by_name = [](const Item& a, const Item& b) { return a.get_name() < b.get_name(); };
+    std::vector<Item> appeared, disappeared;
+    std::set_difference(items.begin(), items.end(), previous.items.begin(), previous.items.end(),
+                        std::back_inserter(appeared), by_name);
+    std::set_difference(previous.items.begin(), previous.items.end(), items.begin(), items.end(),
+                        std::back_inserter(disappeared), by_name);
+    for (const auto& item : appeared) out += "+ Item: " + item.to_string() + "\n";
+    for (const auto& item : disappeared) out += "- Item: " + item.get_name() + "\n";
+
+    std::vector<std::string> arrived, left;
+    std::set_difference(npcs.begin(), npcs.end(), previous.npcs.begin(), previous.npcs.end(),
+                        std::back_inserter(arrived));
+    std::set_difference(previous.npcs.begin(), previous.npcs.end(), npcs.begin(), npcs.end(),
+                        std::back_inserter(left));
+    for (const auto& npc : arrived) out += "+ NPC: " + npc + "\n";
+    for (const auto& npc : left) out += "- NPC: " + npc + "\n";
+
+    for (const auto& [dir, exit] : exits) {
+        auto old = previous.exits.find(dir);
+        if (old == previous.exits.end() || old->second != exit) {
+            out += "+ Direction: " + dir + "- " + exit.first + (exit.second ? " (Visited)" : " (Unknown)") + "\n";
+        }
+    }
+    for (const auto& [dir, exit] : previous.exits) {
+        if (exits.find(dir) == exits.end()) out += "- Direction: " + dir + "\n";
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef LOCATIONVIEW_H
+#define LOCATIONVIEW_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include "Location.h"
+#include "Item.h"
+
+class LocationView {
+private:
+    std::string name;
+    std::vector<Item> items;
+    std::vector<std::string> npcs;
+    std::map<std::string, std::pair<std::string, bool>> exits;
+
+public:
+    // Constructors
+    LocationView();
+    explicit LocationView(const Location& location);
+
+    // True until a Location has been captured
+    bool empty() const;
+
+    // Writes only what changed since `previous`; returns false if the Location itself changed
+    bool write_diff(std::string& out, const LocationView& previous) const;
+};
+
+#endif
@@ -1,25 +1,54 @@
 #include "NPC.h"
-#include <iostream>
+#include <ostream>
+#include <stdexcept>
 
 // Constructor
-NPC::NPC(const std::string& name, const std::string& description, const std::vector<std::string>& messages)
-    : name(name), description(description), message_number(0), messages(messages) {
+NPC::NPC(const std::string& name, PackedText description, std::vector<PackedText> messages)
+    : name(name), description(std::move(description)), message_number(0), messages(std::move(messages)), vars{} {
     if (name.empty()) throw std::invalid_argument("Name cannot be blank.");
-    if (description.empty()) throw std::invalid_argument("Description cannot be blank.");
+    if (this->description.empty()) throw std::invalid_argument("Description cannot be blank.");
+}
+
+NPC::NPC(const std::string& name, PackedText description, std::shared_ptr<const DialogueScript> script)
+    : name(name), description(std::move(description)), message_number(0), script(std::move(script)), vars{} {
+    if (name.empty()) throw std::invalid_argument("Name cannot be blank.");
+    if (this->description.empty()) throw std::invalid_argument("Description cannot be blank.");
+    if (!this->script) throw std::invalid_argument("Script cannot be null.");
 }
 
 // Getters
 std::string NPC::get_name() const { return name; }
-std::string NPC::get_description() const { return description; }
+std::string NPC::get_description() const { return description.str(); }
+
+void NPC::pack(const std::shared_ptr<const TextDictionary>& dictionary) {
+    description.pack(dictionary);
+    for (auto& message : messages) message.pack(dictionary);
+    if (script) {
+        // The script is shared with copies of this NPC, so the packed one replaces it
+        auto packed = std::make_shared<DialogueScript>(*script);
+        packed->pack(dictionary);
+        script = std::move(packed);
+    }
+}
 
 // Get current message and update message number
 std::string NPC::get_message() {
     if (messages.empty()) return "No messages available.";
-    std::string current_message = messages[message_number];
+    std::string current_message = messages[message_number].str();
     message_number = (message_number + 1) % messages.size();
     return current_message;
 }
 
+// Scripted replies keep their state in this NPC's variables
+void NPC::respond(const std::vector<Item>& inventory, int calories_needed, std::string& out) {
+    if (!script) {
+        out += get_message();
+        return;
+    }
+    DialogueContext context{&inventory, calories_needed, vars.data()};
+    if (!script->run(context, out)) out += "...";
+}
+
 // Overloaded stream operator
 std::ostream& operator<<(std::ostream& os, const NPC& npc) {
     os << npc.name;
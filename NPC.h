@@ -1,27 +1,44 @@
 #ifndef NPC_H
 #define NPC_H
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
+#include "DialogueScript.h"
+#include "PackedText.h"
 
 class NPC {
 private:
     std::string name;
-    std::string description;
+    PackedText description;
     int message_number;
-    std::vector<std::string> messages;
+    std::vector<PackedText> messages;
+    std::shared_ptr<const DialogueScript> script;
+    std::array<std::int32_t, DialogueScript::VARS> vars;
 
 public:
     // Constructor
-    NPC(const std::string& name, const std::string& description, const std::vector<std::string>& messages);
+    NPC(const std::string& name, PackedText description, std::vector<PackedText> messages);
+    NPC(const std::string& name, PackedText description, std::shared_ptr<const DialogueScript> script);
 
     // Getters
     std::string get_name() const;
     std::string get_description() const;
 
+    // Packs the description, messages and script with a World's dictionary
+    void pack(const std::shared_ptr<const TextDictionary>& dictionary);
+
     // Get current message and update message number
     std::string get_message();
 
+    // Appends the NPC's reply to a player: its script's words, or the next message
+    void respond(const std::vector<Item>& inventory, int calories_needed, std::string& out);
+
+    // Search reads the description directly to keep it packed
+    friend class SearchIndex;
+
     // Overloaded stream operator
     friend std::ostream& operator<<(std::ostream& os, const NPC& npc);
 };
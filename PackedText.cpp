@@ -0,0 +1,250 @@
+#include "PackedText.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <limits>
+
+namespace {
+
+// Training looks at this much text at most, spread evenly over the corpus
+constexpr std::size_t TRAINING_BYTES = 4 << 20;
+constexpr std::size_t MIN_PHRASE = 3;
+constexpr std::size_t MAX_PHRASE = 48;
+constexpr std::size_t MAX_PIECES = 4;
+
+std::atomic<std::uint64_t> next_id{1};
+
+bool is_literal(unsigned char byte) { return (byte >= 0x01 && byte <= 0x0F) || (byte >= 0x20 && byte <= 0x7F); }
+
+std::uint16_t prefix(std::string_view text, std::size_t at) {
+    return static_cast<std::uint16_t>(static_cast<unsigned char>(text[at]) << 8 | static_cast<unsigned char>(text[at + 1]));
+}
+
+// Where the pieces of a text start: a word with the space before it, or any other single character
+std::vector<std::size_t> piece_starts(std::string_view text) {
+    std::vector<std::size_t> starts;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        starts.push_back(pos);
+        std::size_t word = text[pos] == ' ' ? pos + 1 : pos;
+        std::size_t end = word;
+        while (end < text.size() && std::isalnum(static_cast<unsigned char>(text[end]))) end++;
+        pos = end > word ? end : word == pos ? pos + 1 : word;
+    }
+    starts.push_back(text.size());
+    return starts;
+}
+
+// The last few texts unpacked on this thread
+class RecentTexts {
+private:
+    static constexpr std::size_t SIZE = 64;
+
+    struct Entry {
+        std::uint64_t dictionary = 0;
+        std::size_t hash = 0;
+        std::uint64_t used = 0;
+        std::string packed;
+        std::string text;
+    };
+
+    std::array<Entry, SIZE> entries;
+    std::uint64_t clock = 0;
+
+public:
+    const std::string& get(const TextDictionary& dictionary, std::string_view packed) {
+        std::size_t hash = std::hash<std::string_view>()(packed);
+        Entry* oldest = &entries[0];
+        for (Entry& entry : entries) {
+            if (entry.dictionary == dictionary.get_id() && entry.hash == hash && entry.packed == packed) {
+                entry.used = ++clock;
+                return entry.text;
+            }
+            if (entry.used < oldest->used) oldest = &entry;
+        }
+        oldest->dictionary = dictionary.get_id();
+        oldest->hash = hash;
+        oldest->used = ++clock;
+        oldest->packed.assign(packed);
+        oldest->text.clear();
+        dictionary.decompress(packed, oldest->text);
+        return oldest->text;
+    }
+};
+
+}
+
+std::string_view TextDictionary::entry(std::size_t index) const {
+    return std::string_view(phrases).substr(offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+std::size_t TextDictionary::code_size(std::size_t index) { return index < SHORT_CODES ? 1 : 2; }
+
+/**
+ * @brief Builds a dictionary from the phrases that recur in a corpus.
+ *
+ * Candidates are runs of up to four words (with their leading spaces and
+ * punctuation) that occur at least twice. Each is scored by the bytes it would
+ * save over the whole corpus, less its own size, and the best are kept; the
+ * very best get the one-byte codes.
+ *
+ * @param corpus Every text that will be packed with the dictionary.
+ * @param max_entries How many phrases to keep, at most 4224.
+ * @return The dictionary.
+ */
+std::shared_ptr<const TextDictionary> TextDictionary::train(const std::vector<std::string_view>& corpus,
+                                                            std::size_t max_entries) {
+    std::shared_ptr<TextDictionary> dictionary(new TextDictionary());
+    dictionary->id = next_id++;
+    dictionary->offsets.push_back(0);
+    max_entries = std::min(max_entries, MAX_ENTRIES);
+
+    std::size_t total = 0;
+    for (std::string_view text : corpus) total += text.size();
+    std::size_t stride = total > TRAINING_BYTES ? (total + TRAINING_BYTES - 1) / TRAINING_BYTES : 1;
+
+    std::unordered_map<std::string_view, std::uint32_t> counts;
+    for (std::size_t t = 0; t < corpus.size(); t += stride) {
+        std::string_view text = corpus[t];
+        std::vector<std::size_t> starts = piece_starts(text);
+        for (std::size_t first = 0; first + 1 < starts.size(); first++) {
+            for (std::size_t last = first + 1; last < starts.size() && last - first <= MAX_PIECES; last++) {
+                std::size_t length = starts[last] - starts[first];
+                if (length > MAX_PHRASE) break;
+                if (length >= MIN_PHRASE) counts[text.substr(starts[first], length)]++;
+            }
+        }
+    }
+
+    struct Candidate {
+        std::string_view phrase;
+        std::uint64_t score;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& [phrase, count] : counts) {
+        if (count < 2) continue;
+        std::uint64_t saved = static_cast<std::uint64_t>(count) * (phrase.size() - 2);
+        if (saved > phrase.size()) candidates.push_back({phrase, saved - phrase.size()});
+    }
+    std::size_t kept = std::min(candidates.size(), max_entries);
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(kept), candidates.end(),
+                      [](const Candidate& a, const Candidate& b) {
+                          return a.score != b.score ? a.score > b.score : a.phrase < b.phrase;
+                      });
+
+    for (std::size_t i = 0; i < kept; i++) {
+        std::string_view phrase = candidates[i].phrase;
+        dictionary->phrases.append(phrase);
+        dictionary->offsets.push_back(static_cast<std::uint32_t>(dictionary->phrases.size()));
+        dictionary->by_prefix[prefix(phrase, 0)].push_back(static_cast<std::uint32_t>(i));
+    }
+    dictionary->phrases.shrink_to_fit();
+    return dictionary;
+}
+
+/**
+ * @brief Packs text with the dictionary.
+ *
+ * Finds the cheapest mix of codes and literal bytes by working back from the
+ * end of the text, so a long phrase is never missed for a short one that
+ * happens to start earlier. Compilation pays for this once; unpacking is a
+ * single pass.
+ *
+ * @param text The text to pack.
+ * @return The packed bytes.
+ */
+std::string TextDictionary::compress(std::string_view text) const {
+    constexpr std::uint32_t LITERAL = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::size_t> cost(text.size() + 1, 0);
+    std::vector<std::uint32_t> choice(text.size(), LITERAL);
+    for (std::size_t pos = text.size(); pos-- > 0;) {
+        cost[pos] = (is_literal(static_cast<unsigned char>(text[pos])) ? 1 : 2) + cost[pos + 1];
+        if (pos + 1 >= text.size()) continue;
+        auto found = by_prefix.find(prefix(text, pos));
+        if (found == by_prefix.end()) continue;
+        for (std::uint32_t index : found->second) {
+            std::string_view phrase = entry(index);
+            if (text.compare(pos, phrase.size(), phrase) != 0) continue;
+            std::size_t with = code_size(index) + cost[pos + phrase.size()];
+            if (with < cost[pos]) {
+                cost[pos] = with;
+                choice[pos] = index;
+            }
+        }
+    }
+
+    std::string packed;
+    packed.reserve(cost[0]);
+    for (std::size_t pos = 0; pos < text.size();) {
+        std::uint32_t index = choice[pos];
+        if (index == LITERAL) {
+            auto byte = static_cast<unsigned char>(text[pos++]);
+            if (!is_literal(byte)) packed.push_back('\0');
+            packed.push_back(static_cast<char>(byte));
+        } else if (index < SHORT_CODES) {
+            packed.push_back(static_cast<char>(0x80 + index));
+            pos += entry(index).size();
+        } else {
+            std::size_t code = index - SHORT_CODES;
+            packed.push_back(static_cast<char>(0x10 + (code >> 8)));
+            packed.push_back(static_cast<char>(code & 0xFF));
+            pos += entry(index).size();
+        }
+    }
+    return packed;
+}
+
+void TextDictionary::decompress(std::string_view packed, std::string& out) const {
+    for (std::size_t pos = 0; pos < packed.size(); pos++) {
+        auto byte = static_cast<unsigned char>(packed[pos]);
+        if (byte >= 0x80) {
+            out.append(entry(byte - 0x80));
+        } else if (byte >= 0x10 && byte <= 0x1F) {
+            if (++pos == packed.size()) break;
+            out.append(entry(SHORT_CODES + ((byte - 0x10) << 8 | static_cast<unsigned char>(packed[pos]))));
+        } else if (byte == 0x00) {
+            if (++pos == packed.size()) break;
+            out.push_back(packed[pos]);
+        } else {
+            out.push_back(static_cast<char>(byte));
+        }
+    }
+}
+
+std::uint64_t TextDictionary::get_id() const { return id; }
+std::size_t TextDictionary::size() const { return offsets.size() - 1; }
+
+// Constructors
+PackedText::PackedText(std::string text) : bytes(std::move(text)) {}
+PackedText::PackedText(const char* text) : bytes(text) {}
+
+// Text the dictionary cannot shrink is kept plain, which also skips the cache when showing it
+PackedText::PackedText(std::string_view text, std::shared_ptr<const TextDictionary> dictionary) {
+    if (dictionary && dictionary->size() > 0) {
+        std::string packed = dictionary->compress(text);
+        if (packed.size() < text.size()) {
+            this->dictionary = std::move(dictionary);
+            bytes = std::move(packed);
+            return;
+        }
+    }
+    bytes.assign(text);
+}
+
+const std::string& PackedText::unpacked() const {
+    if (!dictionary) return bytes;
+    thread_local RecentTexts recent;
+    return recent.get(*dictionary, bytes);
+}
+
+std::string PackedText::str() const { return unpacked(); }
+void PackedText::append_to(std::string& out) const { out += unpacked(); }
+
+void PackedText::pack(std::shared_ptr<const TextDictionary> dictionary) {
+    *this = PackedText(unpacked(), std::move(dictionary));
+}
+
+bool PackedText::empty() const { return bytes.empty(); }
+std::size_t PackedText::packed_size() const { return bytes.size(); }
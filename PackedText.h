@@ -0,0 +1,77 @@
+#ifndef PACKEDTEXT_H
+#define PACKEDTEXT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A static dictionary of the phrases that recur across a World's content. It is
+// trained once over every description and message when a template is compiled,
+// then shared by all the text packed with it. Packed text is plain bytes with
+// each dictionary phrase replaced by a one- or two-byte code.
+class TextDictionary {
+private:
+    // Codes: 0x80-0xFF are the first 128 entries, 0x10-0x1F plus a byte the next
+    // 4096; 0x00 escapes the byte after it, anything else stands for itself
+    static constexpr std::size_t SHORT_CODES = 128;
+    static constexpr std::size_t MAX_ENTRIES = SHORT_CODES + 16 * 256;
+
+    std::uint64_t id;                     // unique per dictionary, so caches never mix them up
+    std::string phrases;                  // every entry back to back
+    std::vector<std::uint32_t> offsets;   // entry i is phrases[offsets[i], offsets[i + 1])
+    std::unordered_map<std::uint16_t, std::vector<std::uint32_t>> by_prefix;   // entries by their first two bytes
+
+    // Helper methods
+    std::string_view entry(std::size_t index) const;
+    static std::size_t code_size(std::size_t index);
+
+public:
+    static constexpr std::size_t DEFAULT_ENTRIES = 1024;
+
+    // Picks the phrases that save the most bytes over `corpus`; an empty corpus gives an empty dictionary
+    static std::shared_ptr<const TextDictionary> train(const std::vector<std::string_view>& corpus,
+                                                       std::size_t max_entries = DEFAULT_ENTRIES);
+
+    // Packs text as compactly as the dictionary allows, and unpacks it onto `out`
+    std::string compress(std::string_view text) const;
+    void decompress(std::string_view packed, std::string& out) const;
+
+    std::uint64_t get_id() const;
+    std::size_t size() const;
+};
+
+// A description or message, stored packed with its World's dictionary and
+// unpacked only when it is shown. Recently unpacked texts are kept in a small
+// per-thread cache, since a player looking around sees the same few again and
+// again. Text without a dictionary (from a saved session, say) is kept as is.
+class PackedText {
+private:
+    std::shared_ptr<const TextDictionary> dictionary;
+    std::string bytes;
+
+    const std::string& unpacked() const;
+
+public:
+    // Constructor; plain text converts implicitly so callers that have a string keep working
+    PackedText() = default;
+    PackedText(std::string text);
+    PackedText(const char* text);
+    PackedText(std::string_view text, std::shared_ptr<const TextDictionary> dictionary);
+
+    // The text itself; `append_to` skips the copy
+    std::string str() const;
+    void append_to(std::string& out) const;
+
+    // Packs the text again with another dictionary
+    void pack(std::shared_ptr<const TextDictionary> dictionary);
+
+    bool empty() const;
+
+    // Bytes held for the text, not counting the shared dictionary
+    std::size_t packed_size() const;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "Packer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// One DP row: after[w] = max(before[w], before[w - cost] + gain), noting in
+// `took` which side won. With SSE2 (every x86-64 target) four capacities are
+// done per step; elsewhere the scalar loop is left to the compiler.
+void relax(const int* before, int* after, std::uint8_t* took, std::size_t width, std::size_t cost, int gain) {
+    std::size_t w = 0;
+    for (; w < cost && w < width; w++) {
+        after[w] = before[w];
+        took[w] = 0;
+    }
+#ifdef __SSE2__
+    const __m128i add = _mm_set1_epi32(gain);
+    for (; w + 4 <= width; w += 4) {
+        __m128i keep = _mm_loadu_si128(reinterpret_cast<const __m128i*>(before + w));
+        __m128i with = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(before + w - cost)), add);
+        __m128i mask = _mm_cmpgt_epi32(with, keep);
+        __m128i best = _mm_or_si128(_mm_and_si128(mask, with), _mm_andnot_si128(mask, keep));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(after + w), best);
+        // Narrow the four lane masks to four bytes
+        __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(mask, mask), mask);
+        std::int32_t flags = _mm_cvtsi128_si32(bytes);
+        std::memcpy(took + w, &flags, sizeof(flags));
+    }
+#endif
+    for (; w < width; w++) {
+        int with = before[w - cost] + gain;
+        took[w] = with > before[w];
+        after[w] = std::max(before[w], with);
+    }
+}
+
+}
+
+/**
+ * @brief Finds the calorie-maximizing subset of candidates under a weight cap.
+ *
+ * Dynamic programming over capacities in fixed point: after each candidate,
+ * best[w] is the most calories that fit in w tenths of a pound. Each row is
+ * computed from the previous one into a separate array with a branch-free max,
+ * four capacities at a time; a byte per cell records whether the candidate was
+ * taken, for walking the choices back. Work and memory are
+ * O(candidates x capacity), about 300 cells per candidate at the 30 lb limit.
+ * Candidates without calories are skipped since they can only add weight.
+ *
+ * @param calories Each candidate's calories.
+ * @param weights Each candidate's weight in pounds.
+ * @param capacity The most weight the pack may hold, in pounds.
+ * @return The chosen candidates with their total calories and weight.
+ */
+Packer::Pack Packer::pack(const std::vector<int>& calories, const std::vector<float>& weights, float capacity) {
+    if (calories.size() != weights.size()) throw std::invalid_argument("Calories and weights must line up.");
+    Pack result{{}, 0, 0};
+    if (capacity < 0) return result;
+    const std::size_t limit = static_cast<std::size_t>(std::floor(capacity * SCALE + 1e-3f));
+    const std::size_t width = limit + 1;
+
+    std::vector<std::size_t> candidates;
+    std::vector<std::size_t> costs;
+    for (std::size_t i = 0; i < calories.size(); i++) {
+        if (calories[i] <= 0 || weights[i] < 0) continue;
+        std::size_t cost = static_cast<std::size_t>(std::ceil(weights[i] * SCALE - 1e-3f));
+        if (cost > limit) continue;
+        candidates.push_back(i);
+        costs.push_back(cost);
+    }
+
+    std::vector<int> previous(width, 0);
+    std::vector<int> next(width, 0);
+    std::vector<std::uint8_t> taken(candidates.size() * width);
+    for (std::size_t c = 0; c < candidates.size(); c++) {
+        relax(previous.data(), next.data(), taken.data() + c * width, width, costs[c], calories[candidates[c]]);
+        previous.swap(next);
+    }
+
+    std::size_t w = limit;
+    for (std::size_t c = candidates.size(); c-- > 0;) {
+        if (!taken[c * width + w]) continue;
+        result.picked.push_back(candidates[c]);
+        result.calories += calories[candidates[c]];
+        result.weight += weights[candidates[c]];
+        w -= costs[c];
+    }
+    std::reverse(result.picked.begin(), result.picked.end());
+    return result;
+}
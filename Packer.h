@@ -0,0 +1,25 @@
+#ifndef PACKER_H
+#define PACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Chooses which Items to carry: the 0/1 knapsack that maximizes calories under a
+// weight cap. Weights are rounded up to fixed-point tenths of a pound, so a pack
+// never goes over the cap.
+class Packer {
+public:
+    static constexpr int SCALE = 10;
+
+    struct Pack {
+        std::vector<std::size_t> picked;
+        int calories;
+        float weight;
+    };
+
+    // Candidates are given as columns; `picked` holds indexes into them
+    static Pack pack(const std::vector<int>& calories, const std::vector<float>& weights, float capacity);
+};
+
+#endif
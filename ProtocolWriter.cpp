@@ -0,0 +1,205 @@
+#include "ProtocolWriter.h"
+#include <charconv>
+#include <algorithm>
+
+/*
+ * Binary frame layout (all integers little-endian, strings are u32 length + bytes):
+ *   u32 payload length | u8 version (3) | u8 in_progress | u32 location id | i32 calories_needed
+ *   str location name | u32 item count   { str name, i32 calories, f32 weight }
+ *   u32 exit count     { str direction, u32 location id, u8 visited }
+ *   u32 added count    { str name, i32 calories, f32 weight }
+ *   u32 removed count  { str name, i32 calories, f32 weight }
+ *   str message
+ * Version 1 had u16 counts, which wrapped past 65535 entries; version 2 had u16
+ * string lengths, which cut longer text short.
+ *
+ * JSON carries the same fields; each exit is {"location": id, "visited": bool}.
+ */
+
+// Constructor
+ProtocolWriter::ProtocolWriter(char* buffer, std::size_t capacity, Format format)
+    : buffer(buffer), capacity(capacity), length(0), overflow(false), format(format) {}
+
+// Raw output
+void ProtocolWriter::put(char c) {
+    if (length < capacity) buffer[length++] = c;
+    else overflow = true;
+}
+
+void ProtocolWriter::put(std::string_view text) {
+    if (capacity - length < text.size()) {
+        overflow = true;
+        return;
+    }
+    std::copy(text.begin(), text.end(), buffer + length);
+    length += text.size();
+}
+
+void ProtocolWriter::put_int(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    put(std::string_view(digits, result.ptr - digits));
+}
+
+void ProtocolWriter::put_float(float value) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    put(std::string_view(digits, result.ptr - digits));
+}
+
+void ProtocolWriter::put_u8(std::uint8_t value) { put(static_cast<char>(value)); }
+
+void ProtocolWriter::put_u16(std::uint16_t value) {
+    put_u8(value & 0xff);
+    put_u8(value >> 8);
+}
+
+void ProtocolWriter::put_u32(std::uint32_t value) {
+    put_u16(value & 0xffff);
+    put_u16(value >> 16);
+}
+
+void ProtocolWriter::patch_u32(std::size_t offset, std::uint32_t value) {
+    if (overflow) return;
+    for (int i = 0; i < 4; i++) buffer[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+// Encoded values
+void ProtocolWriter::json_string(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (char c : text) {
+        auto u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(c);
+        } else if (c == '\n') {
+            put("\\n");
+        } else if (u < 0x20) {
+            put("\\u00");
+            put(hex[u >> 4]);
+            put(hex[u & 0xf]);
+        } else {
+            put(c);
+        }
+    }
+    put('"');
+}
+
+void ProtocolWriter::binary_string(std::string_view text) {
+    put_u32(static_cast<std::uint32_t>(text.size()));
+    put(text);
+}
+
+void ProtocolWriter::begin_items(const char* key, std::size_t count) {
+    if (format == Format::BINARY) {
+        put_u32(static_cast<std::uint32_t>(count));
+        return;
+    }
+    put(",\"");
+    put(key);
+    put("\":[");
+}
+
+void ProtocolWriter::put_item(std::string_view name, int calories, float weight, bool first) {
+    if (format == Format::BINARY) {
+        binary_string(name);
+        put_u32(static_cast<std::uint32_t>(calories));
+        std::uint32_t bits;
+        std::copy_n(reinterpret_cast<const char*>(&weight), 4, reinterpret_cast<char*>(&bits));
+        put_u32(bits);
+        return;
+    }
+    if (!first) put(',');
+    put("{\"name\":");
+    json_string(name);
+    put(",\"calories\":");
+    put_int(calories);
+    put(",\"weight\":");
+    put_float(weight);
+    put('}');
+}
+
+void ProtocolWriter::end_items() {
+    if (format == Format::JSON) put(']');
+}
+
+void ProtocolWriter::write_items(const char* key, const std::vector<Item>& items) {
+    begin_items(key, items.size());
+    for (std::size_t i = 0; i < items.size(); i++) put_item(items[i].name, items[i].calories, items[i].weight, i == 0);
+    end_items();
+}
+
+// A Location's Items are read from the entity store columns
+void ProtocolWriter::write_items(const char* key, const Location& location) {
+    begin_items(key, location.items.size());
+    bool first = true;
+    location.entities->for_rows(location.items, [&](std::string_view name, int calories, float weight) {
+        put_item(name, calories, weight, first);
+        first = false;
+    });
+    end_items();
+}
+
+// Event serialization
+void ProtocolWriter::write_event(const ProtocolEvent& event) {
+    const Location& location = *event.location;
+
+    if (format == Format::BINARY) {
+        std::size_t start = length;
+        put_u32(0);
+        put_u8(3);
+        put_u8(event.in_progress ? 1 : 0);
+        put_u32(static_cast<std::uint32_t>(event.location_id));
+        put_u32(static_cast<std::uint32_t>(event.calories_needed));
+        binary_string(location.name);
+        write_items("items", location);
+        put_u32(static_cast<std::uint32_t>(location.neighbors.size()));
+        for (const auto& [dir, loc] : location.neighbors) {
+            binary_string(dir);
+            put_u32(static_cast<std::uint32_t>(loc - event.world));
+            put_u8(loc->visited ? 1 : 0);
+        }
+        write_items("inventory_added", *event.inventory_added);
+        write_items("inventory_removed", *event.inventory_removed);
+        binary_string(event.message);
+        patch_u32(start, static_cast<std::uint32_t>(length - start - 4));
+        return;
+    }
+
+    put("{\"location\":");
+    put_int(event.location_id);
+    put(",\"name\":");
+    json_string(location.name);
+    put(",\"calories_needed\":");
+    put_int(event.calories_needed);
+    put(",\"in_progress\":");
+    put(event.in_progress ? "true" : "false");
+    write_items("items", location);
+    put(",\"exits\":{");
+    bool first = true;
+    for (const auto& [dir, loc] : location.neighbors) {
+        if (!first) put(',');
+        first = false;
+        json_string(dir);
+        put(":{\"location\":");
+        put_int(loc - event.world);
+        put(",\"visited\":");
+        put(loc->visited ? "true}" : "false}");
+    }
+    put('}');
+    write_items("inventory_added", *event.inventory_added);
+    write_items("inventory_removed", *event.inventory_removed);
+    put(",\"message\":");
+    json_string(event.message);
+    put("}\n");
+}
+
+// Output access
+std::string_view ProtocolWriter::data() const { return std::string_view(buffer, length); }
+bool ProtocolWriter::overflowed() const { return overflow; }
+
+void ProtocolWriter::clear() {
+    length = 0;
+    overflow = false;
+}
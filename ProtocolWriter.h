@@ -0,0 +1,66 @@
+#ifndef PROTOCOLWRITER_H
+#define PROTOCOLWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "Location.h"
+#include "Item.h"
+
+// Everything a client needs to know after one command; all fields are borrowed, nothing is copied
+struct ProtocolEvent {
+    int location_id;
+    const Location* location;
+    const Location* world;   // first Location of the world, used to number exits
+    const std::vector<Item>* inventory_added;
+    const std::vector<Item>* inventory_removed;
+    int calories_needed;
+    bool in_progress;
+    std::string_view message;
+};
+
+class ProtocolWriter {
+public:
+    enum class Format { JSON, BINARY };
+
+private:
+    char* buffer;
+    std::size_t capacity;
+    std::size_t length;
+    bool overflow;
+    Format format;
+
+    // Raw output
+    void put(char c);
+    void put(std::string_view text);
+    void put_int(long long value);
+    void put_float(float value);
+    void put_u8(std::uint8_t value);
+    void put_u16(std::uint16_t value);
+    void put_u32(std::uint32_t value);
+    void patch_u32(std::size_t offset, std::uint32_t value);
+
+    // Encoded values
+    void json_string(std::string_view text);
+    void binary_string(std::string_view text);
+    void begin_items(const char* key, std::size_t count);
+    void put_item(std::string_view name, int calories, float weight, bool first);
+    void end_items();
+    void write_items(const char* key, const std::vector<Item>& items);
+    void write_items(const char* key, const Location& location);
+
+public:
+    // Constructor; the writer never allocates and only writes into `buffer`
+    ProtocolWriter(char* buffer, std::size_t capacity, Format format);
+
+    // Serializes one event as a JSON line or a length-prefixed binary frame
+    void write_event(const ProtocolEvent& event);
+
+    // Output access
+    std::string_view data() const;
+    bool overflowed() const;
+    void clear();
+};
+
+#endif
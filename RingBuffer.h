@@ -0,0 +1,131 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Bounded lock-free queues used to hand lines between network and game threads.
+// Capacities are rounded up to a power of two. "Single" producer or consumer
+// means one at a time: the role may move between threads as long as each
+// hand-off is synchronized (as Session's `scheduled` flag does).
+
+namespace ring_detail {
+    constexpr std::size_t CACHE_LINE = 64;
+
+    inline std::size_t round_up(std::size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("Ring capacity cannot be zero.");
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+}
+
+// Single-producer single-consumer ring. Each side caches the other side's index
+// so the shared cache line is only read when the ring looks full or empty.
+template <typename T>
+class SpscRing {
+private:
+    std::size_t mask;
+    std::unique_ptr<T[]> slots;
+    alignas(ring_detail::CACHE_LINE) std::atomic<std::size_t> head;   // next slot to pop
+    alignas(ring_detail::CACHE_LINE) std::size_t cached_tail;         // consumer's view of tail
+    alignas(ring_detail::CACHE_LINE) std::atomic<std::size_t> tail;   // next slot to push
+    alignas(ring_detail::CACHE_LINE) std::size_t cached_head;         // producer's view of head
+
+public:
+    // Constructor
+    explicit SpscRing(std::size_t capacity)
+        : mask(ring_detail::round_up(capacity) - 1), slots(new T[mask + 1]), head(0), cached_tail(0), tail(0),
+          cached_head(0) {}
+
+    // Producer side; returns false when full
+    bool try_push(T&& value) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask) return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false when empty
+    bool try_pop(T& value) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) return false;
+        }
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when read by a third thread
+    std::size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return mask + 1; }
+};
+
+// Multi-producer single-consumer ring (Vyukov's bounded queue). Producers claim
+// a slot with one CAS on the tail; each slot's sequence number tells the
+// consumer when the value in it has been published.
+template <typename T>
+class MpscRing {
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(ring_detail::CACHE_LINE) std::atomic<std::size_t> tail;   // next slot to claim
+    alignas(ring_detail::CACHE_LINE) std::size_t head;                // consumer only
+
+public:
+    // Constructor
+    explicit MpscRing(std::size_t capacity)
+        : mask(ring_detail::round_up(capacity) - 1), cells(new Cell[mask + 1]), tail(0), head(0) {
+        for (std::size_t i = 0; i <= mask; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Producer side, safe from any number of threads; returns false when full
+    bool try_push(T&& value) {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (lag == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (lag < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false when empty (or the next value is not published yet)
+    bool try_pop(T& value) {
+        Cell& cell = cells[head & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        value = std::move(cell.value);
+        cell.sequence.store(head + mask + 1, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "RuleBook.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include "Location.h"
+
+namespace {
+
+struct Token {
+    std::string text;
+    bool quoted;
+};
+
+std::invalid_argument rule_error(int line, const std::string& message) {
+    return std::invalid_argument("Rule line " + std::to_string(line) + ": " + message);
+}
+
+// Splits a line into words and quoted strings; ':' and ',' are tokens of their own
+std::vector<Token> tokenize(std::string_view line, int line_number) {
+    std::vector<Token> tokens;
+    std::size_t pos = 0;
+    while (pos < line.size()) {
+        char c = line[pos];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            pos++;
+        } else if (c == '#') {
+            break;
+        } else if (c == ':' || c == ',') {
+            tokens.push_back({std::string(1, c), false});
+            pos++;
+        } else if (c == '"') {
+            std::size_t end = line.find('"', pos + 1);
+            if (end == std::string_view::npos) throw rule_error(line_number, "unterminated string.");
+            tokens.push_back({std::string(line.substr(pos + 1, end - pos - 1)), true});
+            pos = end + 1;
+        } else {
+            std::size_t end = line.find_first_of(" \t\r#:,\"", pos);
+            if (end == std::string_view::npos) end = line.size();
+            tokens.push_back({std::string(line.substr(pos, end - pos)), false});
+            pos = end;
+        }
+    }
+    return tokens;
+}
+
+int parse_number(const std::vector<Token>& tokens, int line_number) {
+    int value = 0;
+    if (tokens.size() != 2 || tokens[1].quoted) throw rule_error(line_number, "expected one number.");
+    const std::string& text = tokens[1].text;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) throw rule_error(line_number, "expected one number.");
+    return value;
+}
+
+}
+
+// Constructor
+RuleBook::RuleBook() : goal(500), win_at(0) {}
+
+RuleBook::Table::Table() : class_count(0) {}
+
+/**
+ * @brief Parses rule text into patterns and effects.
+ *
+ * Item names are given small ids here (0 stands for any Item not named by a
+ * rule) so the bound table can be indexed directly.
+ *
+ * @param source The rule text.
+ * @return The parsed rules.
+ */
+RuleBook RuleBook::compile(std::string_view source) {
+    RuleBook book;
+    int line_number = 0;
+    std::size_t pos = 0;
+    while (pos <= source.size()) {
+        std::size_t end = source.find('\n', pos);
+        if (end == std::string_view::npos) end = source.size();
+        std::vector<Token> tokens = tokenize(source.substr(pos, end - pos), ++line_number);
+        pos = end + 1;
+        if (tokens.empty()) continue;
+
+        const std::string& keyword = tokens[0].text;
+        if (keyword == "goal") {
+            book.goal = parse_number(tokens, line_number);
+            continue;
+        }
+        if (keyword == "win") {
+            book.win_at = parse_number(tokens, line_number);
+            continue;
+        }
+        if (keyword != "on") throw rule_error(line_number, "expected 'on', 'goal' or 'win'.");
+
+        // on ACTION ITEM at LOCATION [if edible|inedible] : EFFECT {, EFFECT}
+        Pattern pattern{Action::GIVE, "", "", -1, book.rules.size(), line_number};
+        std::size_t i = 1;
+        auto next = [&](const char* what) -> const Token& {
+            if (i >= tokens.size()) throw rule_error(line_number, std::string("expected ") + what + ".");
+            return tokens[i++];
+        };
+        const Token& action = next("an action");
+        if (action.text == "give") pattern.action = Action::GIVE;
+        else if (action.text == "take") pattern.action = Action::TAKE;
+        else throw rule_error(line_number, "unknown action '" + action.text + "'.");
+        pattern.item = next("an Item").text;
+        if (next("'at'").text != "at") throw rule_error(line_number, "expected 'at'.");
+        pattern.location = next("a Location").text;
+        const Token* token = &next("':'");
+        if (token->text == "if" && !token->quoted) {
+            const Token& condition = next("a condition");
+            if (condition.text == "edible") pattern.edible = 1;
+            else if (condition.text == "inedible") pattern.edible = 0;
+            else throw rule_error(line_number, "unknown condition '" + condition.text + "'.");
+            token = &next("':'");
+        }
+        if (token->text != ":" || token->quoted) throw rule_error(line_number, "expected ':'.");
+
+        Rule rule;
+        for (;;) {
+            const Token& effect = next("an effect");
+            if (effect.text == "say") {
+                const Token& text = next("quoted text");
+                if (!text.quoted) throw rule_error(line_number, "expected quoted text.");
+                rule.effects.push_back({Effect::Kind::SAY, text.text + "\n"});
+            } else if (effect.text == "feed") {
+                rule.effects.push_back({Effect::Kind::FEED, ""});
+            } else if (effect.text == "teleport") {
+                rule.effects.push_back({Effect::Kind::TELEPORT, ""});
+            } else if (effect.text == "keep" && pattern.action == Action::GIVE) {
+                rule.effects.push_back({Effect::Kind::KEEP, ""});
+            } else {
+                throw rule_error(line_number, "unknown effect '" + effect.text + "'.");
+            }
+            if (i == tokens.size()) break;
+            if (tokens[i].text != "," || tokens[i].quoted) throw rule_error(line_number, "expected ','.");
+            i++;
+        }
+
+        if (pattern.item != "*") book.item_ids.emplace(pattern.item, book.item_ids.size() + 1);
+        book.rules.push_back(std::move(rule));
+        book.patterns.push_back(std::move(pattern));
+    }
+    return book;
+}
+
+std::shared_ptr<const RuleBook> RuleBook::standard() {
+    static const std::shared_ptr<const RuleBook> book = std::make_shared<const RuleBook>(compile(R"(
+        goal 500
+        win 0
+        on give * at *: say "You can only give items to the Elf in the Woods."
+        on give * at Woods if edible: say "You gave the Elf {calories} calories.", feed
+        on give * at Woods if inedible: say "The Elf is displeased and teleports you away!", teleport
+    )"));
+    return book;
+}
+
+/**
+ * @brief Resolves the rules against a World's Locations into a dispatch table.
+ *
+ * Each Location named by a rule gets a class of its own and every other
+ * Location shares class 0, since the same rules apply to all of them. The
+ * table has one slot per (action, edibility, Item id, Location class).
+ * Patterns are applied from least to most specific, so each slot ends up
+ * holding the rule that wins for it.
+ *
+ * @param book The rules to bind.
+ * @param locations The World's Locations; a Location's id is its index.
+ * @return The dispatch table.
+ */
+RuleBook::Table RuleBook::bind(std::shared_ptr<const RuleBook> book, const std::vector<Location>& locations) {
+    Table table;
+    table.location_classes.assign(locations.size(), 0);
+    table.class_count = 1;
+    std::unordered_map<std::string, std::uint32_t> classes;
+    for (const auto& pattern : book->patterns) {
+        if (pattern.location == "*" || classes.count(pattern.location)) continue;
+        auto found = std::find_if(locations.begin(), locations.end(),
+                                  [&](const Location& l) { return l.get_name() == pattern.location; });
+        if (found == locations.end()) throw rule_error(pattern.line, "no Location named '" + pattern.location + "'.");
+        auto location_class = static_cast<std::uint32_t>(table.class_count++);
+        classes.emplace(pattern.location, location_class);
+        table.location_classes[static_cast<std::size_t>(found - locations.begin())] = location_class;
+    }
+
+    std::size_t item_count = book->item_ids.size() + 1;
+    table.slots.assign(ACTIONS * 2 * item_count * table.class_count, -1);
+
+    std::vector<const Pattern*> ordered;
+    for (const auto& pattern : book->patterns) ordered.push_back(&pattern);
+    auto specificity = [](const Pattern* p) {
+        return (p->item != "*") * 4 + (p->location != "*") * 2 + (p->edible >= 0);
+    };
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [&](const Pattern* a, const Pattern* b) { return specificity(a) < specificity(b); });
+
+    for (const Pattern* pattern : ordered) {
+        std::size_t first_class = 0;
+        std::size_t last_class = table.class_count;
+        if (pattern->location != "*") {
+            first_class = classes.at(pattern->location);
+            last_class = first_class + 1;
+        }
+        for (std::size_t item = 0; item < item_count; item++) {
+            if (pattern->item != "*" && item != book->item_ids.at(pattern->item)) continue;
+            for (int edible = 0; edible < 2; edible++) {
+                if (pattern->edible >= 0 && edible != pattern->edible) continue;
+                std::size_t row = ((static_cast<std::size_t>(pattern->action) * 2 + edible) * item_count + item);
+                for (std::size_t location_class = first_class; location_class < last_class; location_class++) {
+                    table.slots[row * table.class_count + location_class] = static_cast<std::int32_t>(pattern->rule);
+                }
+            }
+        }
+    }
+    table.book = std::move(book);
+    return table;
+}
+
+const RuleBook::Rule* RuleBook::Table::find(Action action, const std::string& item, int location_id, bool edible) const {
+    if (!book || location_id < 0 || static_cast<std::size_t>(location_id) >= location_classes.size()) return nullptr;
+    auto named = book->item_ids.find(item);
+    std::size_t item_id = named == book->item_ids.end() ? 0 : named->second;
+    std::size_t row = (static_cast<std::size_t>(action) * 2 + edible) * (book->item_ids.size() + 1) + item_id;
+    std::int32_t rule = slots[row * class_count + location_classes[static_cast<std::size_t>(location_id)]];
+    return rule < 0 ? nullptr : &book->rules[static_cast<std::size_t>(rule)];
+}
+
+// Win condition
+int RuleBook::get_goal() const { return goal; }
+int RuleBook::get_win_at() const { return win_at; }
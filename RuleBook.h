@@ -0,0 +1,94 @@
+#ifndef RULEBOOK_H
+#define RULEBOOK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Location;
+
+// Declarative game rules: what giving or taking an Item does where, the Elf's
+// calorie goal, and when the game is won. Rule text looks like
+//   goal 500
+//   win 0
+//   on give * at Woods if edible: say "You gave the Elf {calories} calories.", feed
+//   on take "Rusty Nail" at *: say "Ouch!"
+// Items and Locations are names (quoted if they contain spaces) or * for any;
+// `if edible`/`if inedible` tests the Item's calories. When several rules match,
+// the most specific wins (Item, then Location, then condition), and among equals
+// the one written last. Effects run in order:
+//   say "TEXT"   print TEXT; {item} and {calories} are replaced
+//   feed         give the Item's calories to the Elf
+//   teleport     send the player somewhere random
+//   keep         (give only) the player keeps the Item
+class RuleBook {
+public:
+    enum class Action : std::uint8_t { GIVE, TAKE };
+    static constexpr std::size_t ACTIONS = 2;
+
+    struct Effect {
+        enum class Kind : std::uint8_t { SAY, FEED, TELEPORT, KEEP };
+        Kind kind;
+        std::string text;
+    };
+
+    struct Rule {
+        std::vector<Effect> effects;
+    };
+
+    // Rules bound to one World's Locations: every lookup is two array indexes. Locations
+    // that no rule names share class 0, so the table grows with the rules, not the World
+    class Table {
+    private:
+        std::shared_ptr<const RuleBook> book;
+        std::vector<std::uint32_t> location_classes;   // by Location id
+        std::size_t class_count;
+        std::vector<std::int32_t> slots;
+
+        friend class RuleBook;
+
+    public:
+        Table();
+
+        // The rule for an action, or nullptr if none applies
+        const Rule* find(Action action, const std::string& item, int location_id, bool edible) const;
+    };
+
+private:
+    struct Pattern {
+        Action action;
+        std::string item;
+        std::string location;
+        int edible;
+        std::size_t rule;
+        int line;
+    };
+
+    std::vector<Rule> rules;
+    std::vector<Pattern> patterns;
+    std::unordered_map<std::string, std::size_t> item_ids;
+    int goal;
+    int win_at;
+
+public:
+    // Constructor; an empty rule book with the default goal
+    RuleBook();
+
+    // Parses rule text; throws std::invalid_argument naming the bad line
+    static RuleBook compile(std::string_view source);
+
+    // The rules of the original game, compiled once
+    static std::shared_ptr<const RuleBook> standard();
+
+    // Builds the dispatch table for a World; throws if a rule names an unknown Location
+    static Table bind(std::shared_ptr<const RuleBook> book, const std::vector<Location>& locations);
+
+    // Win condition
+    int get_goal() const;
+    int get_win_at() const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "Scheduler.h"
+#include <algorithm>
+
+namespace {
+    // The pool and worker this thread belongs to, if any
+    thread_local const Scheduler* current_scheduler = nullptr;
+    thread_local std::size_t current_worker = 0;
+}
+
+// Constructor
+Scheduler::Scheduler(std::size_t worker_count) : queued(0), sleeping(0), next_worker(0), stopping(false) {
+    if (worker_count == 0) worker_count = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < worker_count; i++) workers.push_back(std::make_unique<Worker>());
+    for (std::size_t i = 0; i < worker_count; i++) threads.emplace_back([this, i] { run_worker(i); });
+}
+
+// Destructor
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+// Submission
+void Scheduler::submit(std::function<void()> task) {
+    std::size_t index = current_scheduler == this ? current_worker : next_worker++ % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    queued++;
+    if (sleeping.load() > 0) {
+        // Taking the lock orders this wakeup after a sleeper's final check of `queued`
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        wake.notify_one();
+    }
+}
+
+std::size_t Scheduler::worker_count() const { return workers.size(); }
+
+// Task sources
+bool Scheduler::pop_local(std::size_t index, std::function<void()>& task) {
+    std::lock_guard<std::mutex> lock(workers[index]->mutex);
+    if (workers[index]->tasks.empty()) return false;
+    task = std::move(workers[index]->tasks.front());
+    workers[index]->tasks.pop_front();
+    return true;
+}
+
+bool Scheduler::steal(std::size_t thief, std::function<void()>& task) {
+    for (std::size_t i = 1; i < workers.size(); i++) {
+        Worker& victim = *workers[(thief + i) % workers.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+// Worker loop
+void Scheduler::run_worker(std::size_t index) {
+    current_scheduler = this;
+    current_worker = index;
+    std::function<void()> task;
+    while (true) {
+        if (pop_local(index, task) || steal(index, task)) {
+            queued--;
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        if (stopping && queued.load() == 0) return;
+        sleeping++;
+        wake.wait(lock, [this] { return queued.load() > 0 || stopping; });
+        sleeping--;
+    }
+}
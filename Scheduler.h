@@ -0,0 +1,53 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool: each worker runs its own deque in submission order
+// (so a busy worker stays fair to every Session queued on it) and steals the
+// newest task from another worker when it runs dry
+class Scheduler {
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> queued;
+    std::atomic<std::size_t> sleeping;
+    std::atomic<std::size_t> next_worker;
+    std::atomic<bool> stopping;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+
+    // Helper methods
+    void run_worker(std::size_t index);
+    bool pop_local(std::size_t index, std::function<void()>& task);
+    bool steal(std::size_t thief, std::function<void()>& task);
+
+public:
+    // Constructor; zero workers means one per hardware thread
+    explicit Scheduler(std::size_t worker_count = 0);
+
+    // Runs every task already submitted, then joins the workers
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Queues a task; tasks submitted from a worker stay on that worker's deque
+    void submit(std::function<void()> task);
+
+    std::size_t worker_count() const;
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include "Location.h"
+
+namespace {
+
+constexpr float K1 = 1.2f;
+constexpr float B = 0.75f;
+
+void put_varint(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint32_t get_varint(const std::uint8_t*& in) {
+    std::uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        std::uint8_t byte = *in++;
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+    }
+}
+
+}
+
+// Walks one compressed posting list, block by block
+struct SearchIndex::Cursor {
+    const std::uint8_t* data;
+    const Block* first;
+    const Block* end;
+    const Block* block;
+    const Block* shallow;
+    const std::uint8_t* next;
+    std::uint32_t remaining;
+    std::uint32_t document;
+    std::uint32_t frequency;
+    float idf;
+    float max_score;
+    bool done;
+
+    Cursor(const std::uint8_t* data, const Block* first, const Term& term, float idf)
+        : data(data), first(first), end(first + term.block_count), block(first), shallow(first), next(nullptr), remaining(0),
+          document(0), frequency(0), idf(idf), max_score(term.max_score), done(false) {
+        enter(first);
+        advance();
+    }
+
+    void enter(const Block* target) {
+        block = target;
+        next = data + block->offset;
+        remaining = block->count;
+        document = block == first ? 0 : (block - 1)->last_document;
+    }
+
+    void advance() {
+        if (remaining == 0) {
+            if (block + 1 == end) {
+                done = true;
+                return;
+            }
+            enter(block + 1);
+        }
+        document += get_varint(next);
+        frequency = get_varint(next);
+        remaining--;
+    }
+
+    // The block that would hold `target` (without decoding anything), or nullptr past the end
+    const Block* block_for(std::uint32_t target) {
+        while (shallow != end && shallow->last_document < target) shallow++;
+        return shallow == end ? nullptr : shallow;
+    }
+
+    // Moves past the current block without decoding the rest of it
+    void next_block() {
+        if (block + 1 == end) {
+            done = true;
+            return;
+        }
+        enter(block + 1);
+        advance();
+    }
+
+    // Moves to the first posting at or after `target`, skipping blocks that end before it
+    void seek(std::uint32_t target) {
+        if (done || document >= target) return;
+        if (block->last_document < target) {
+            const Block* skip = block + 1;
+            while (skip != end && skip->last_document < target) skip++;
+            if (skip == end) {
+                done = true;
+                return;
+            }
+            enter(skip);
+            advance();
+        }
+        while (!done && document < target) advance();
+    }
+};
+
+// Constructors
+SearchIndex::SearchIndex() : average_length(0) {}
+
+/**
+ * @brief Builds the inverted index over the given documents.
+ *
+ * Names count twice so that a match in a name outranks one in a description.
+ * Each term's posting list is delta-encoded with varints, which keeps lists for
+ * common words to roughly two bytes per document, and split into blocks that
+ * carry their last document and best BM25 score for skipping.
+ *
+ * @param documents The documents to index.
+ */
+SearchIndex::SearchIndex(std::vector<Document> documents) : documents(std::move(documents)), average_length(0) {
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> lists;
+    std::vector<std::string> names;
+    std::vector<std::uint32_t> document_terms;
+    std::uint64_t total_length = 0;
+    lengths.reserve(this->documents.size());
+
+    for (std::uint32_t id = 0; id < this->documents.size(); id++) {
+        const Document& document = this->documents[id];
+        document_terms.clear();
+        auto add = [&](std::string_view text, int weight) {
+            for (auto& term : terms_of(text)) {
+                auto [found, inserted] = ids.try_emplace(std::move(term), static_cast<std::uint32_t>(lists.size()));
+                if (inserted) {
+                    lists.emplace_back();
+                    names.push_back(found->first);
+                }
+                for (int i = 0; i < weight; i++) document_terms.push_back(found->second);
+            }
+        };
+        add(document.name, 2);
+        add(document.description.str(), 1);
+        std::sort(document_terms.begin(), document_terms.end());
+        for (std::size_t i = 0; i < document_terms.size();) {
+            std::size_t j = i;
+            while (j < document_terms.size() && document_terms[j] == document_terms[i]) j++;
+            lists[document_terms[i]].emplace_back(id, static_cast<std::uint32_t>(j - i));
+            i = j;
+        }
+        lengths.push_back(static_cast<std::uint32_t>(document_terms.size()));
+        total_length += document_terms.size();
+    }
+    if (!this->documents.empty()) average_length = static_cast<double>(total_length) / this->documents.size();
+
+    terms.reserve(lists.size());
+    for (std::size_t t = 0; t < lists.size(); t++) {
+        const auto& list = lists[t];
+        float term_idf = idf(static_cast<std::uint32_t>(list.size()));
+        Term entry{blocks.size(), 0, static_cast<std::uint32_t>(list.size()), 0};
+        std::uint32_t previous = 0;
+        for (std::size_t start = 0; start < list.size(); start += BLOCK) {
+            std::size_t end = std::min(list.size(), start + BLOCK);
+            Block block{list[end - 1].first, static_cast<std::uint32_t>(end - start), postings.size(), 0};
+            for (std::size_t i = start; i < end; i++) {
+                put_varint(postings, list[i].first - previous);
+                put_varint(postings, list[i].second);
+                previous = list[i].first;
+                block.max_score = std::max(block.max_score, term_score(term_idf, list[i].second, list[i].first));
+            }
+            entry.max_score = std::max(entry.max_score, block.max_score);
+            blocks.push_back(block);
+        }
+        entry.block_count = blocks.size() - entry.first_block;
+        terms.emplace(std::move(names[t]), entry);
+    }
+    postings.shrink_to_fit();
+    blocks.shrink_to_fit();
+}
+
+SearchIndex SearchIndex::build(const std::vector<Location>& locations) {
+    std::vector<Document> documents;
+    for (std::size_t id = 0; id < locations.size(); id++) {
+        const Location& location = locations[id];
+        int location_id = static_cast<int>(id);
+        documents.push_back({Kind::LOCATION, location.get_name(), location.description, location_id});
+        for (const auto& npc : location.get_npcs()) {
+            documents.push_back({Kind::NPC, npc.get_name(), npc.description, location_id});
+        }
+        std::vector<std::string> seen;
+        for (const auto& item : location.get_items()) {
+            if (std::find(seen.begin(), seen.end(), item.get_name()) != seen.end()) continue;
+            seen.push_back(item.get_name());
+            documents.push_back({Kind::ITEM, item.get_name(), item.description, location_id});
+        }
+    }
+    return SearchIndex(std::move(documents));
+}
+
+/**
+ * @brief Splits text into search terms.
+ *
+ * Terms are runs of letters and digits, lowercased, with a plural 's' dropped
+ * so that "restaurant" finds "restaurants".
+ *
+ * @param text The text to split.
+ * @return The terms in order.
+ */
+std::vector<std::string> SearchIndex::terms_of(std::string_view text) {
+    std::vector<std::string> result;
+    std::string term;
+    for (std::size_t i = 0; i <= text.size(); i++) {
+        unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+        if (std::isalnum(c)) {
+            term += static_cast<char>(std::tolower(c));
+        } else if (!term.empty()) {
+            if (term.size() > 3 && term.back() == 's' && term[term.size() - 2] != 's') term.pop_back();
+            result.push_back(std::move(term));
+            term.clear();
+        }
+    }
+    return result;
+}
+
+// BM25 weights
+float SearchIndex::idf(std::uint32_t document_count) const {
+    double n = static_cast<double>(documents.size());
+    return static_cast<float>(std::log(1.0 + (n - document_count + 0.5) / (document_count + 0.5)));
+}
+
+float SearchIndex::term_score(float idf, std::uint32_t frequency, std::uint32_t document) const {
+    float norm = K1 * (1 - B + B * static_cast<float>(lengths[document] / average_length));
+    return idf * frequency * (K1 + 1) / (frequency + norm);
+}
+
+/**
+ * @brief Finds the documents that best match a query.
+ *
+ * Posting lists are walked in step, one document at a time, keeping the best
+ * `limit` in a heap (MaxScore). Once the heap is full, lists whose best score
+ * could not lift a document into it on their own stop driving the walk and are
+ * only probed, skipping whole blocks, for documents the other lists produce; a
+ * candidate is dropped as soon as its remaining best case cannot beat the heap.
+ * Blocks whose best score cannot reach the heap are skipped undecoded. A rare
+ * word therefore costs little even next to a word in every document.
+ *
+ * @param query Words to look for.
+ * @param limit The most results to return.
+ * @return Matches, best first.
+ */
+std::vector<SearchIndex::Result> SearchIndex::search(std::string_view query, std::size_t limit) const {
+    std::vector<Result> best;
+    if (limit == 0) return best;
+    std::vector<std::string> words = terms_of(query);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::vector<Cursor> cursors;
+    for (const auto& word : words) {
+        auto found = terms.find(word);
+        if (found == terms.end()) continue;
+        const Term& term = found->second;
+        cursors.emplace_back(postings.data(), blocks.data() + term.first_block, term, idf(term.document_count));
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) { return a.max_score < b.max_score; });
+
+    // bounds[i]: the most lists 0..i together can add to a document
+    std::vector<float> bounds(cursors.size());
+    float running = 0;
+    for (std::size_t i = 0; i < cursors.size(); i++) bounds[i] = running += cursors[i].max_score;
+
+    auto worse = [](const Result& a, const Result& b) { return a.score > b.score; };
+    float threshold = 0;
+    std::size_t essential = 0;
+    for (;;) {
+        std::uint32_t document = UINT32_MAX;
+        for (std::size_t i = essential; i < cursors.size(); i++) {
+            Cursor& cursor = cursors[i];
+            // Skip blocks that cannot place a document even with every other list's best
+            if (best.size() == limit) {
+                float others = bounds.back() - cursor.max_score;
+                while (!cursor.done && cursor.block->max_score + others <= threshold) cursor.next_block();
+            }
+            if (!cursor.done) document = std::min(document, cursor.document);
+        }
+        if (document == UINT32_MAX) break;
+
+        // If no document up to the end of the shortest block here can place, jump past it
+        if (best.size() == limit) {
+            float bound = 0;
+            std::uint32_t region_end = UINT32_MAX;
+            for (auto& cursor : cursors) {
+                const Block* block = cursor.done ? nullptr : cursor.block_for(document);
+                if (block == nullptr) continue;
+                bound += block->max_score;
+                region_end = std::min(region_end, block->last_document);
+            }
+            if (bound <= threshold) {
+                if (region_end == UINT32_MAX) break;
+                for (std::size_t i = essential; i < cursors.size(); i++) cursors[i].seek(region_end + 1);
+                continue;
+            }
+        }
+
+        float score = 0;
+        for (std::size_t i = essential; i < cursors.size(); i++) {
+            Cursor& cursor = cursors[i];
+            if (cursor.done || cursor.document != document) continue;
+            score += term_score(cursor.idf, cursor.frequency, document);
+            cursor.advance();
+        }
+        bool full = best.size() == limit;
+        for (std::size_t i = essential; i-- > 0;) {
+            if (full && score + bounds[i] <= threshold) break;
+            Cursor& cursor = cursors[i];
+            cursor.seek(document);
+            if (!cursor.done && cursor.document == document) score += term_score(cursor.idf, cursor.frequency, document);
+        }
+
+        if (!full) {
+            best.push_back({&documents[document], score});
+            std::push_heap(best.begin(), best.end(), worse);
+        } else if (score > threshold) {
+            std::pop_heap(best.begin(), best.end(), worse);
+            best.back() = {&documents[document], score};
+            std::push_heap(best.begin(), best.end(), worse);
+        }
+        if (best.size() == limit) {
+            threshold = best.front().score;
+            while (essential < cursors.size() && bounds[essential] <= threshold) essential++;
+        }
+    }
+    std::sort_heap(best.begin(), best.end(), worse);
+    return best;
+}
+
+std::size_t SearchIndex::size() const { return documents.size(); }
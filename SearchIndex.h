@@ -0,0 +1,82 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "PackedText.h"
+
+class Location;
+
+// Inverted index over the names and descriptions of Locations, Items and NPCs.
+// Built once when the World is created; Items and NPCs are indexed where they
+// start out (which is also where Items respawn).
+class SearchIndex {
+public:
+    enum class Kind : std::uint8_t { LOCATION, ITEM, NPC };
+
+    struct Document {
+        Kind kind;
+        std::string name;
+        PackedText description;
+        int location_id;
+    };
+
+    struct Result {
+        const Document* document;
+        double score;
+    };
+
+private:
+    // Posting lists are stored back to back as varint (document gap, term frequency)
+    // pairs, cut into blocks that record where they end and their best score so a
+    // query can skip whole blocks without decoding them
+    static constexpr std::uint32_t BLOCK = 128;
+
+    struct Block {
+        std::uint32_t last_document;
+        std::uint32_t count;
+        std::size_t offset;
+        float max_score;
+    };
+
+    struct Term {
+        std::size_t first_block;
+        std::size_t block_count;
+        std::uint32_t document_count;
+        float max_score;
+    };
+
+    struct Cursor;
+
+    std::vector<Document> documents;
+    std::vector<std::uint32_t> lengths;
+    std::unordered_map<std::string, Term> terms;
+    std::vector<std::uint8_t> postings;
+    std::vector<Block> blocks;
+    double average_length;
+
+    // Helper methods
+    float idf(std::uint32_t document_count) const;
+    float term_score(float idf, std::uint32_t frequency, std::uint32_t document) const;
+
+public:
+    // Constructors; the second indexes the given documents (ids are their positions)
+    SearchIndex();
+    explicit SearchIndex(std::vector<Document> documents);
+
+    // Indexes a World's Locations with the Items and NPCs in them
+    static SearchIndex build(const std::vector<Location>& locations);
+
+    // Splits text into lowercase search terms
+    static std::vector<std::string> terms_of(std::string_view text);
+
+    // Best matches first (BM25); results point into the index
+    std::vector<Result> search(std::string_view query, std::size_t limit = 10) const;
+
+    std::size_t size() const;
+};
+
+#endif
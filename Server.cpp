@@ -0,0 +1,373 @@
+/**
+ * @file Server.cpp
+ * @brief Line server for GVZork and its epoll backend.
+ *
+ * Each reactor is a single-threaded event loop with its own epoll instance and
+ * its own SO_REUSEPORT listening socket, so the kernel spreads new connections
+ * across reactors and no state is shared between them except the World.
+ * Sockets are non-blocking and level-triggered; a connection whose client
+ * stops reading has EPOLLIN disabled until its output drains (backpressure).
+ * With scheduler workers, sessions run off the reactors; a reactor is woken
+ * through its eventfd when their replies are ready to send.
+ * The io_uring backend lives in UringReactor.cpp and shares Connection.
+ */
+
+#include "Server.h"
+#include "Connection.h"
+#include "UringReactor.h"
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    std::system_error os_error(const char* what) { return std::system_error(errno, std::generic_category(), what); }
+
+    int open_listener(const std::string& address, std::uint16_t port) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw os_error("socket");
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+            close(fd);
+            throw std::invalid_argument("Invalid listen address: " + address);
+        }
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+            auto error = os_error("bind/listen");
+            close(fd);
+            throw error;
+        }
+        return fd;
+    }
+
+    // 50k connections need more descriptors than the usual soft limit of 1024
+    void raise_fd_limit() {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+class EpollReactor : public Server::Reactor {
+private:
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr int READS_PER_EVENT = 16;
+
+    struct Entry {
+        std::unique_ptr<Connection> connection;
+        std::uint32_t interest;
+        bool registered;   // in the epoll set, even with no interest
+    };
+
+    Server& server;
+    int epoll_fd;
+    int listen_fd;
+    int wake_fd;
+    std::unordered_map<int, Entry> connections;
+    std::unique_ptr<SessionArchive> archive;
+    std::chrono::steady_clock::time_point next_sweep;
+    ReadyList ready;
+
+    void accept_all();
+    void sweep();
+    void service_ready();
+    void service(Entry& entry, std::uint32_t events);
+    bool flush(Connection& connection);
+    void drop(int fd);
+
+public:
+    EpollReactor(Server& server, int listen_fd);
+    ~EpollReactor() override;
+    void run() override;
+    void wake() override;
+};
+
+// Reactor setup
+EpollReactor::EpollReactor(Server& server, int listen_fd)
+    : server(server), listen_fd(listen_fd), archive(server.make_archive()),
+      next_sweep(std::chrono::steady_clock::now() + server.get_sweep_interval()), ready([this] { wake(); }) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) throw os_error("epoll/eventfd");
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+EpollReactor::~EpollReactor() {
+    for (auto& [fd, entry] : connections) close(fd);
+    close(listen_fd);
+    close(wake_fd);
+    close(epoll_fd);
+}
+
+void EpollReactor::wake() {
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd, &one, sizeof(one));
+}
+
+// Event loop
+void EpollReactor::run() {
+    epoll_event events[MAX_EVENTS];
+    while (!server.is_stopping()) {
+        int timeout = -1;
+        if (archive) {
+            auto until = std::chrono::ceil<std::chrono::milliseconds>(next_sweep - std::chrono::steady_clock::now());
+            timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, until.count()));
+        }
+        int count = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw os_error("epoll_wait");
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                accept_all();
+            } else if (fd == wake_fd) {
+                service_ready();
+            } else {
+                auto found = connections.find(fd);
+                if (found != connections.end()) service(found->second, events[i].events);
+            }
+        }
+        if (archive && std::chrono::steady_clock::now() >= next_sweep) sweep();
+    }
+}
+
+// Clears the wakeup before taking the list, so a session reported after this still wakes the loop
+void EpollReactor::service_ready() {
+    std::uint64_t count = 0;
+    [[maybe_unused]] auto read_bytes = read(wake_fd, &count, sizeof(count));
+    for (auto& [fd, session] : ready.take()) {
+        auto found = connections.find(fd);
+        if (found != connections.end() && found->second.connection->get_session() == session.get()) {
+            service(found->second, 0);
+        }
+    }
+}
+
+// Hibernates connections that have been idle long enough; they keep their EPOLLIN interest
+void EpollReactor::sweep() {
+    auto now = std::chrono::steady_clock::now();
+    auto idle_since = now - server.get_hibernate_after();
+    std::size_t hibernated = 0;
+    for (auto& [fd, entry] : connections) hibernated += entry.connection->hibernate(idle_since);
+    if (hibernated > 0) Server::release_memory();
+    next_sweep = now + server.get_sweep_interval();
+}
+
+void EpollReactor::accept_all() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) std::cerr << "accept: " << std::strerror(errno) << "\n";
+            return;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        Entry& entry = connections[fd];
+        entry.connection = std::make_unique<Connection>(fd, server.get_host(), archive.get(), server.get_journal(),
+                                                        server.get_scheduler(), ready.notifier(fd));
+        entry.interest = 0;
+        entry.registered = false;
+        service(entry, 0);
+    }
+}
+
+/**
+ * @brief Handles readiness on one connection.
+ *
+ * Reads what is available (bounded per event so one chatty client cannot
+ * monopolize the reactor), runs complete lines, writes as much output as the
+ * socket accepts, then updates the epoll interest set to match what the
+ * connection is waiting for.
+ */
+void EpollReactor::service(Entry& entry, std::uint32_t events) {
+    Connection& connection = *entry.connection;
+    int fd = connection.get_fd();
+    if (events & EPOLLERR) {
+        drop(fd);
+        return;
+    }
+
+    char buffer[16384];
+    for (int i = 0; i < READS_PER_EVENT && connection.wants_input() && (events & (EPOLLIN | EPOLLHUP)); i++) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            if (!connection.receive(buffer, static_cast<std::size_t>(received))) {
+                drop(fd);
+                return;
+            }
+            if (static_cast<std::size_t>(received) < sizeof(buffer)) break;
+        } else if (received == 0) {
+            connection.end_of_input();
+            break;
+        } else {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                drop(fd);
+                return;
+            }
+            break;
+        }
+    }
+
+    // Keep going while the socket takes all our output and lines are still buffered
+    while (true) {
+        bool more = connection.process();
+        if (!flush(connection)) {
+            drop(fd);
+            return;
+        }
+        if (!more || !connection.pending_output().empty()) break;
+    }
+    if (connection.finished()) {
+        drop(fd);
+        return;
+    }
+
+    std::uint32_t interest = 0;
+    if (connection.wants_input()) interest |= EPOLLIN | EPOLLRDHUP;
+    if (!connection.pending_output().empty()) interest |= EPOLLOUT;
+    if (interest != entry.interest) {
+        epoll_event event{};
+        event.events = interest;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, entry.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+        entry.interest = interest;
+        entry.registered = true;
+    }
+}
+
+/**
+ * @brief Writes pending output until it is gone or the socket would block.
+ *
+ * @return False on a socket error, in which case the connection should be dropped.
+ */
+bool EpollReactor::flush(Connection& connection) {
+    while (!connection.pending_output().empty()) {
+        std::string_view data = connection.pending_output();
+        ssize_t sent = send(connection.get_fd(), data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.consume_output(static_cast<std::size_t>(sent));
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    return true;
+}
+
+void EpollReactor::drop(int fd) {
+    // Closing the descriptor also removes it from the epoll set
+    close(fd);
+    connections.erase(fd);
+}
+
+// Server
+Server::Server(const Options& options) : options(options), stopping(false) {
+    if (options.reactors < 1) throw std::invalid_argument("At least one reactor is required.");
+    if (options.workers < 0) throw std::invalid_argument("Worker count cannot be negative.");
+    if (options.hibernate_after.count() < 0) throw std::invalid_argument("Hibernation time cannot be negative.");
+    if (options.session_ttl.count() < 0) throw std::invalid_argument("Session lifetime cannot be negative.");
+    host = std::make_shared<WorldHost>(options.content, options.rules, options.shared_world);
+    if (!options.journal_directory.empty()) {
+        Journal::Options settings;
+        settings.directory = options.journal_directory;
+        settings.commit_interval = options.commit_interval;
+        settings.autosave_interval = options.autosave_interval;
+        settings.autosave_rate = options.autosave_rate;
+        settings.session_ttl = options.session_ttl;
+        journal = std::make_unique<Journal>(settings);
+        Journal::Progress progress;
+        if (std::shared_ptr<World> shared = host->get_release()->world) {
+            journal->restore_world(*shared);
+            progress = [host = host](std::string& out) {
+                if (std::shared_ptr<World> world = host->get_release()->world) world->save_progress(out);
+            };
+        }
+        journal->start(std::move(progress));
+    }
+    raise_fd_limit();
+    if (options.workers > 0) scheduler = std::make_unique<Scheduler>(static_cast<std::size_t>(options.workers));
+    for (int i = 0; i < options.reactors; i++) {
+        int listen_fd = open_listener(options.address, options.port);
+        std::unique_ptr<Reactor> reactor;
+        if (options.backend == Backend::IO_URING) reactor = make_uring_reactor(*this, listen_fd);
+        if (!reactor) reactor = std::make_unique<EpollReactor>(*this, listen_fd);
+        reactors.push_back(std::move(reactor));
+    }
+}
+
+Server::~Server() = default;
+
+void Server::run() {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < reactors.size(); i++) threads.emplace_back([this, i] { reactors[i]->run(); });
+    reactors[0]->run();
+    for (auto& thread : threads) thread.join();
+}
+
+void Server::stop() {
+    stopping = true;
+    for (auto& reactor : reactors) reactor->wake();
+}
+
+bool Server::is_stopping() const { return stopping.load(); }
+
+void Server::reload(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules) {
+    host->reload(std::move(content), std::move(rules));
+}
+
+std::shared_ptr<WorldHost> Server::get_host() const { return host; }
+
+Journal* Server::get_journal() const { return journal.get(); }
+
+Scheduler* Server::get_scheduler() const { return scheduler.get(); }
+
+std::unique_ptr<SessionArchive> Server::make_archive() const {
+    if (options.hibernate_after.count() == 0) return nullptr;
+    std::string directory = options.hibernate_directory;
+    if (directory.empty()) directory = std::filesystem::temp_directory_path().string();
+    return std::make_unique<SessionArchive>(directory);
+}
+
+std::chrono::milliseconds Server::get_hibernate_after() const { return options.hibernate_after; }
+
+// A session hibernates at most a quarter of its idle time late
+std::chrono::milliseconds Server::get_sweep_interval() const {
+    return std::max<std::chrono::milliseconds>(std::chrono::milliseconds(100), get_hibernate_after() / 4);
+}
+
+// glibc keeps freed heap for reuse; hibernated sessions are meant to give it back
+void Server::release_memory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
@@ -0,0 +1,89 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Journal.h"
+#include "Scheduler.h"
+#include "SessionArchive.h"
+#include "WorldHost.h"
+
+// Line-protocol front end: each TCP connection gets its own Game session
+class Server {
+public:
+    enum class Backend { EPOLL, IO_URING };
+
+    struct Options {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 4000;
+        int reactors = 1;            // event loops, each on its own thread with its own listening socket
+        int workers = 0;             // threads running game commands off the reactors; 0 runs them on the reactors
+        bool shared_world = false;   // all connections play in one World instead of one World each
+        Backend backend = Backend::EPOLL;   // IO_URING falls back to EPOLL if the kernel refuses it
+        std::shared_ptr<const RuleBook> rules = RuleBook::standard();   // game variant every World plays by
+        std::shared_ptr<const WorldTemplate> content = WorldTemplate::standard();
+        std::chrono::seconds hibernate_after{0};   // idle time before a session is saved to disk; 0 keeps all in memory
+        std::string hibernate_directory;           // where hibernated sessions go; empty for the temporary directory
+        std::string journal_directory;             // where sessions are logged to survive restarts; empty for no journal
+        std::chrono::microseconds commit_interval{1000};   // how long the journal gathers records into one fsync
+        std::chrono::seconds autosave_interval{60};        // time between journal snapshots
+        std::uint64_t autosave_rate = 32 << 20;            // bytes per second a snapshot may write; 0 for no limit
+        std::chrono::seconds session_ttl{24 * 60 * 60};    // how long the journal keeps an unplayed session; 0 for ever
+    };
+
+    // One event loop serving the connections accepted on its listening socket
+    class Reactor {
+    public:
+        virtual ~Reactor() = default;
+        virtual void run() = 0;
+        virtual void wake() = 0;
+    };
+
+private:
+    Options options;
+    std::shared_ptr<WorldHost> host;
+    std::unique_ptr<Journal> journal;
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    std::unique_ptr<Scheduler> scheduler;   // goes first, finishing sessions that still report to reactors
+    std::atomic<bool> stopping;
+
+public:
+    // Constructor; recovers the journal and binds the listening sockets
+    explicit Server(const Options& options);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Serves until stop() is called
+    void run();
+
+    // Safe to call from any thread or a signal handler
+    void stop();
+
+    // Swaps in new content and rules without dropping connections; safe from any
+    // thread but not a signal handler. Throws std::invalid_argument if they do not
+    // build a World, leaving the current ones in place
+    void reload(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules);
+
+    // Used by reactors
+    bool is_stopping() const;
+    std::shared_ptr<WorldHost> get_host() const;
+    Journal* get_journal() const;
+    Scheduler* get_scheduler() const;   // null when sessions run on the reactors
+
+    // Hibernation for a reactor's connections: its archive (null when off), how
+    // long a session idles before going in, and how often to look for such sessions
+    std::unique_ptr<SessionArchive> make_archive() const;
+    std::chrono::milliseconds get_hibernate_after() const;
+    std::chrono::milliseconds get_sweep_interval() const;
+
+    // Returns memory freed by hibernated sessions to the system
+    static void release_memory();
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "Session.h"
+#include <charconv>
+#include <system_error>
+
+namespace {
+    std::string hex(std::uint64_t value) {
+        char digits[16];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value, 16).ptr;
+        return std::string(digits, end);
+    }
+}
+
+// Constructor
+Session::Session(std::shared_ptr<WorldHost> host, Journal* journal, std::string& out)
+    : host(std::move(host)), game(std::make_unique<Game>(this->host)), loop(play_async(*game)), hibernating(false),
+      saved{}, journal(journal), token(0), scheduler(nullptr), pending(0), scheduled(false), stalled(false),
+      signalled(false), input_closed(false), over(false), disconnected(false) {
+    if (journal) {
+        token = journal->new_token();
+        out += "Your session is " + hex(token) + ". If you are disconnected, reconnect and type 'resume " +
+               hex(token) + "' to pick up where you left off.\n";
+    }
+    out += loop->output();
+}
+
+Session::~Session() {
+    if (journal && !logged.empty()) journal->detach(token, std::move(logged));
+}
+
+// Running inline
+void Session::execute(std::string_view line, std::string& out) {
+    if (journal && line.starts_with("resume ")) resume(line.substr(7), out);
+    else out += loop->feed(line);
+}
+
+void Session::close(std::string& out) { out += loop->close(); }
+
+bool Session::done() const { return loop && loop->done(); }
+
+void Session::log_state() {
+    if (!journal) return;
+    if (loop->done()) {
+        if (!logged.empty()) journal->end(token);
+        logged.clear();
+        return;
+    }
+    saving.clear();
+    game->save(saving);
+    if (Game::same_state(saving, logged)) return;
+    journal->record(token, saving);
+    logged.swap(saving);
+}
+
+/**
+ * @brief Takes over a session from the journal in place of this one.
+ *
+ * The current session ends (it is no longer needed once the player has their
+ * old one back), and the resumed one is shown where it left off.
+ *
+ * @param id The session's token, as shown when it started.
+ * @param out Receives the reply.
+ */
+void Session::resume(std::string_view id, std::string& out) {
+    std::uint64_t wanted = 0;
+    auto [end, error] = std::from_chars(id.data(), id.data() + id.size(), wanted, 16);
+    std::optional<std::string> state;
+    if (error == std::errc() && end == id.data() + id.size()) state = journal->resume(wanted);
+    std::unique_ptr<Game> resumed;
+    try {
+        if (state) resumed = std::make_unique<Game>(host, *state);
+    } catch (const std::invalid_argument&) {
+        state.reset();
+    }
+    if (!resumed) {
+        out += "There is no session " + std::string(id) + " to resume.\n";
+        out += game->prompt();
+        return;
+    }
+
+    if (!logged.empty()) journal->end(token);
+    loop.reset();
+    game = std::move(resumed);
+    loop.emplace(play_async(*game, true));
+    token = wanted;
+    logged = std::move(*state);
+    out += "Welcome back.\n";
+    out += game->prompt();
+}
+
+// Scheduling
+void Session::attach(Scheduler& scheduler, Notify notify) {
+    this->scheduler = &scheduler;
+    this->notify = std::move(notify);
+    inbox = std::make_unique<MpscRing<std::string>>(QUEUE);
+    outbox = std::make_unique<SpscRing<std::string>>(QUEUE);
+    over = done();
+}
+
+// `pending` counts the line before a worker can pop it, so it never runs below the inbox
+bool Session::post(std::string line) {
+    pending++;
+    if (!inbox->try_push(std::move(line))) {
+        pending--;
+        return false;
+    }
+    schedule();
+    return true;
+}
+
+void Session::close_input() {
+    input_closed = true;
+    schedule();
+}
+
+void Session::drain(std::string& out) {
+    signalled = false;
+    bool drained_any = false;
+    std::string chunk;
+    while (outbox->try_pop(chunk)) {
+        out += chunk;
+        drained_any = true;
+    }
+    if (drained_any && stalled.exchange(false)) schedule();
+}
+
+bool Session::idle() const { return pending.load() == 0 && !scheduled.load(); }
+bool Session::is_over() const { return over.load(); }
+bool Session::drained() const { return outbox->size() == 0; }
+
+// A stalled Session is not queued anywhere, so it simply goes with its last reference
+void Session::disconnect() { disconnected = true; }
+
+/**
+ * @brief Tells the connection that output is waiting, at most once per drain.
+ *
+ * Called once at the end of a batch rather than per command, so a burst of
+ * commands costs the reactor a single wakeup.
+ */
+void Session::signal() {
+    if (!signalled.exchange(true) && notify && !disconnected) notify(shared_from_this());
+}
+
+/**
+ * @brief Hands the Session to the Scheduler unless it is already queued or running.
+ *
+ * The `scheduled` flag is what keeps commands ordered: at most one worker runs
+ * a Session at a time, so Game's handlers never see concurrent calls. It also
+ * batches wakeups, since lines posted while the Session is queued ride along.
+ * The task holds a reference, so a Session whose connection closes finishes
+ * its batch first.
+ */
+void Session::schedule() {
+    bool expected = false;
+    if (scheduled.compare_exchange_strong(expected, true)) {
+        scheduler->submit([self = shared_from_this()] { self->run(); });
+    }
+}
+
+/**
+ * @brief Executes up to one batch of queued lines on a worker.
+ *
+ * Running a bounded batch and then yielding keeps a busy Session from starving
+ * others on the same worker. If more input is waiting the Session resubmits
+ * itself behind whatever else is queued on that worker. If the outbox fills
+ * up the Session stalls until the connection drains it. End of input is
+ * handled once every line before it has run; the journal hears about the
+ * session once per batch.
+ */
+void Session::run() {
+    bool changed = false;
+    bool full = false;
+    std::string line;
+    for (std::size_t i = 0; i < BATCH; i++) {
+        if (!disconnected && !done() && outbox->size() >= outbox->capacity()) {
+            full = true;
+            break;
+        }
+        if (!inbox->try_pop(line)) break;
+        if (!disconnected && !done()) {
+            std::string reply;
+            execute(line, reply);
+            outbox->try_push(std::move(reply));
+        }
+        pending--;
+        changed = true;
+    }
+    if (!full && input_closed && pending.load() == 0 && !done() && outbox->size() < outbox->capacity()) {
+        std::string reply;
+        close(reply);
+        outbox->try_push(std::move(reply));
+        changed = true;
+    }
+    if (changed) {
+        log_state();
+        if (done()) over = true;
+        signal();
+    }
+
+    if (full) {
+        stalled = true;
+        scheduled = false;
+        // The connection may have drained between the check and setting `stalled`
+        if (outbox->size() < outbox->capacity() && stalled.exchange(false)) schedule();
+        return;
+    }
+    scheduled = false;
+    if (pending.load() > 0 || (input_closed && !over)) schedule();
+}
+
+// Hibernation
+bool Session::hibernate(SessionArchive& archive) {
+    if (hibernating || (scheduler && (!idle() || !drained())) || done()) return false;
+    std::string bytes;
+    game->save(bytes);
+    try {
+        saved = archive.put(bytes);
+    } catch (const std::system_error&) {
+        return false;   // stays awake; the archive may have room next time
+    }
+    // The loop refers to the Game, so it goes first
+    loop.reset();
+    game.reset();
+    hibernating = true;
+    return true;
+}
+
+/**
+ * @brief Brings a hibernated session back.
+ *
+ * The loop resumes waiting for a line, since the player has already seen the
+ * prompt. If the saved session cannot be read back, the player starts over
+ * rather than being disconnected.
+ */
+void Session::wake(SessionArchive& archive, std::string& out) {
+    try {
+        game = std::make_unique<Game>(host, archive.take(saved));
+        loop.emplace(play_async(*game, true));
+    } catch (const std::exception&) {
+        game = std::make_unique<Game>(host);
+        loop.emplace(play_async(*game));
+        out += "Your saved game could not be restored; starting over.\n";
+    }
+    out += loop->output();
+    hibernating = false;
+}
+
+bool Session::is_hibernating() const { return hibernating.load(); }
@@ -0,0 +1,108 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "Game.h"
+#include "GameLoop.h"
+#include "Journal.h"
+#include "RingBuffer.h"
+#include "Scheduler.h"
+#include "SessionArchive.h"
+#include "WorldHost.h"
+
+// One player's game, apart from the connection it is played over: the Game and
+// its loop, hibernation to a SessionArchive, and logging to a Journal under the
+// token the player resumes with ("resume TOKEN"). Its Connection either runs it
+// inline on the reactor thread, or hands it to a Scheduler: lines then go in
+// through a lock-free inbox, replies come back through an outbox, and the
+// Session runs a batch at a time on whichever worker picks it up. Either way
+// its commands run in order, one at a time.
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    // Called from a worker when output is waiting; not called again until `drain` runs
+    using Notify = std::function<void(std::shared_ptr<Session>)>;
+
+    static constexpr std::size_t QUEUE = 16;   // lines a scheduled Session buffers each way
+
+private:
+    static constexpr std::size_t BATCH = 16;
+
+    std::shared_ptr<WorldHost> host;
+    std::unique_ptr<Game> game;       // null while hibernating
+    std::optional<GameLoop> loop;
+    std::atomic<bool> hibernating;    // readable while a worker may be replacing `game`
+    SessionArchive::Record saved;
+    Journal* journal;
+    std::uint64_t token;
+    std::string logged;   // last state sent to the journal; empty if none or the game ended
+    std::string saving;
+
+    // Only used once the Session runs on a Scheduler
+    Scheduler* scheduler;
+    Notify notify;
+    std::unique_ptr<MpscRing<std::string>> inbox;
+    std::unique_ptr<SpscRing<std::string>> outbox;
+    std::atomic<std::size_t> pending;
+    std::atomic<bool> scheduled;
+    std::atomic<bool> stalled;
+    std::atomic<bool> signalled;
+    std::atomic<bool> input_closed;
+    std::atomic<bool> over;
+    std::atomic<bool> disconnected;
+
+    // Helper methods
+    void resume(std::string_view id, std::string& out);
+    void schedule();
+    void run();
+    void signal();
+
+public:
+    // Constructor; starts a new game and appends its greeting to `out`. Without a journal
+    // the session does not outlive its connection
+    Session(std::shared_ptr<WorldHost> host, Journal* journal, std::string& out);
+
+    // A session cut off mid-game stays in the journal for its player to resume
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Running inline: one line (or end of input), appending the reply to `out`;
+    // log_state records the session in the journal if it changed
+    void execute(std::string_view line, std::string& out);
+    void close(std::string& out);
+    void log_state();
+    bool done() const;
+
+    // Running on a Scheduler from now on; `notify` says when output is waiting
+    void attach(Scheduler& scheduler, Notify notify);
+
+    // Scheduled use, from the connection's thread: post returns false while the inbox is full,
+    // close_input follows the last line, drain appends queued replies to `out`
+    bool post(std::string line);
+    void close_input();
+    void drain(std::string& out);
+
+    // Scheduled state: no line waiting or running; the game has ended and every reply is
+    // queued; and no reply is left to drain
+    bool idle() const;
+    bool is_over() const;
+    bool drained() const;
+
+    // The connection is gone; lines still queued are dropped
+    void disconnect();
+
+    // Hibernation, from the connection's thread while idle: saves the Game to `archive`
+    // (false if it cannot), and brings it back, appending any notice to `out`
+    bool hibernate(SessionArchive& archive);
+    void wake(SessionArchive& archive, std::string& out);
+    bool is_hibernating() const;
+};
+
+#endif
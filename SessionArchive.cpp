@@ -0,0 +1,70 @@
+#include "SessionArchive.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+#include <vector>
+
+namespace {
+    std::system_error os_error(const char* what) { return std::system_error(errno, std::generic_category(), what); }
+}
+
+// Constructor
+SessionArchive::SessionArchive(const std::string& directory) : end(0), live(0) {
+    std::string path = directory + "/gvzork-sessions-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    fd = mkostemp(name.data(), O_CLOEXEC);
+    if (fd < 0) throw os_error("mkostemp");
+    unlink(name.data());
+}
+
+SessionArchive::~SessionArchive() { close(fd); }
+
+SessionArchive::Record SessionArchive::put(std::string_view bytes) {
+    Record record{end, static_cast<std::uint32_t>(bytes.size())};
+    std::size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t result = pwrite(fd, bytes.data() + written, bytes.size() - written, static_cast<off_t>(end + written));
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            throw os_error("pwrite");
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    end += bytes.size();
+    live++;
+    return record;
+}
+
+/**
+ * @brief Reads a record back and releases it.
+ *
+ * The record's blocks are punched out of the file so long-lived sleepers do
+ * not pin the space of everyone who woke up; when the last record goes, the
+ * file is truncated and offsets start from zero again.
+ *
+ * @param record A record returned by put and not taken before; it is gone even if reading fails.
+ * @return The stored bytes.
+ */
+std::string SessionArchive::take(Record record) {
+    live--;
+    std::string bytes(record.size, '\0');
+    std::size_t read_so_far = 0;
+    while (read_so_far < bytes.size()) {
+        ssize_t result = pread(fd, bytes.data() + read_so_far, bytes.size() - read_so_far,
+                               static_cast<off_t>(record.offset + read_so_far));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) throw result < 0 ? os_error("pread") : std::system_error(EIO, std::generic_category(), "pread");
+        read_so_far += static_cast<std::size_t>(result);
+    }
+    if (live == 0) {
+        if (ftruncate(fd, 0) == 0) end = 0;
+    } else {
+        // Best effort; a filesystem without hole punching just keeps the bytes
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(record.offset), record.size);
+    }
+    return bytes;
+}
+
+std::size_t SessionArchive::size() const { return live; }
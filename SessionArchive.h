@@ -0,0 +1,42 @@
+#ifndef SESSIONARCHIVE_H
+#define SESSIONARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Disk storage for hibernated sessions: one anonymous, append-only file. Each
+// saved session is a record that is read back once, after which its space is
+// returned to the filesystem; the file starts over whenever no records are
+// left. Not thread-safe; each server reactor keeps its own.
+class SessionArchive {
+public:
+    struct Record {
+        std::uint64_t offset;
+        std::uint32_t size;
+    };
+
+private:
+    int fd;
+    std::uint64_t end;
+    std::size_t live;
+
+public:
+    // Constructor; the file is created in `directory` and unlinked at once, so
+    // it disappears with the process. Throws std::system_error
+    explicit SessionArchive(const std::string& directory);
+    ~SessionArchive();
+
+    SessionArchive(const SessionArchive&) = delete;
+    SessionArchive& operator=(const SessionArchive&) = delete;
+
+    // Stores and retrieves records; both throw std::system_error on I/O errors
+    Record put(std::string_view bytes);
+    std::string take(Record record);
+
+    // Records stored and not yet taken
+    std::size_t size() const;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "Simulator.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <stdexcept>
+#include <thread>
+#include "World.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// xorshift32; states are never zero
+inline std::uint32_t next_random(std::uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Maps a random word onto [0, range) without division
+inline std::uint32_t scale(std::uint32_t random, std::uint32_t range) {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(random) * range) >> 32);
+}
+
+// Moves agents [first, last) through a random exit each. With SSE2 the random
+// states and the choice of exit are computed four agents at a time; the loads of
+// exit lists stay scalar since SSE2 has no gather. Both paths move agents
+// identically.
+void walk(const std::uint32_t* offsets, const std::uint32_t* targets, std::uint32_t* positions,
+          std::uint32_t* states, std::size_t first, std::size_t last) {
+    std::size_t a = first;
+#ifdef __SSE2__
+    const __m128i high = _mm_set_epi32(-1, 0, -1, 0);
+    alignas(16) std::uint32_t begin[4];
+    alignas(16) std::uint32_t degree[4];
+    alignas(16) std::uint32_t exit[4];
+    for (; a + 4 <= last; a += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + a));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(states + a), x);
+        for (int lane = 0; lane < 4; lane++) {
+            begin[lane] = offsets[positions[a + lane]];
+            degree[lane] = offsets[positions[a + lane] + 1] - begin[lane];
+        }
+        // High halves of the four 32x32-bit products, then offset into the exit lists
+        __m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(degree));
+        __m128i even = _mm_srli_epi64(_mm_mul_epu32(x, d), 32);
+        __m128i odd = _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(d, 32)), high);
+        __m128i pick = _mm_add_epi32(_mm_or_si128(even, odd), _mm_load_si128(reinterpret_cast<const __m128i*>(begin)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(exit), pick);
+        for (int lane = 0; lane < 4; lane++) {
+            if (degree[lane]) positions[a + lane] = targets[exit[lane]];
+        }
+    }
+#endif
+    for (; a < last; a++) {
+        std::uint32_t random = next_random(states[a]);
+        std::uint32_t begin = offsets[positions[a]];
+        std::uint32_t degree = offsets[positions[a] + 1] - begin;
+        if (degree) positions[a] = targets[begin + scale(random, degree)];
+    }
+}
+
+// Moves agents [first, last) toward the neighbor with the most food, or through
+// a random exit when none has any. The scan starts at a random exit so ties
+// are split evenly.
+void forage(const std::uint32_t* offsets, const std::uint32_t* targets, int* food, std::uint32_t* positions,
+            std::uint32_t* states, std::size_t first, std::size_t last) {
+    for (std::size_t a = first; a < last; a++) {
+        std::uint32_t random = next_random(states[a]);
+        std::uint32_t begin = offsets[positions[a]];
+        std::uint32_t degree = offsets[positions[a] + 1] - begin;
+        if (!degree) continue;
+        std::uint32_t start = scale(random, degree);
+        std::uint32_t best = targets[begin + start];
+        int most = std::atomic_ref<int>(food[best]).load(std::memory_order_relaxed);
+        for (std::uint32_t i = 1; i < degree; i++) {
+            std::uint32_t target = targets[begin + (start + i) % degree];
+            int here = std::atomic_ref<int>(food[target]).load(std::memory_order_relaxed);
+            if (here > most) {
+                best = target;
+                most = here;
+            }
+        }
+        positions[a] = best;
+    }
+}
+
+}
+
+/**
+ * @brief Sets up the agents and copies the food lying in the World.
+ *
+ * Each agent's random state is seeded from the seed and its index, so a run is
+ * repeatable for a given seed (contested food aside, see run()).
+ *
+ * @param world The World to walk; it must outlive the Simulator.
+ * @param options How many agents, where they start and how they move.
+ */
+Simulator::Simulator(const World& world, const Options& options)
+    : graph(world.get_exit_graph()), options(options) {
+    const std::size_t locations = graph.size();
+    if (locations == 0) throw std::invalid_argument("The World has no Locations.");
+    if (options.start >= static_cast<int>(locations)) throw std::invalid_argument("Start Location is out of range.");
+
+    positions.resize(options.agents);
+    states.resize(options.agents);
+    eaten.assign(options.agents, 0);
+    for (std::size_t a = 0; a < options.agents; a++) {
+        // splitmix64 of the seed and index
+        std::uint64_t z = (static_cast<std::uint64_t>(options.seed) << 32 | a) + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        states[a] = static_cast<std::uint32_t>(z) | 1;
+        positions[a] = options.start >= 0 ? static_cast<std::uint32_t>(options.start)
+                                          : scale(static_cast<std::uint32_t>(z >> 32), static_cast<std::uint32_t>(locations));
+    }
+
+    food.assign(locations, 0);
+    world.get_entities().for_each([this](std::uint32_t, std::int32_t owner, std::string_view, int calories, float) {
+        food[static_cast<std::size_t>(owner)] += calories;
+    });
+    visits.assign(locations, 0);
+}
+
+// Moves agents [first, last) once, then lets each eat what is where it arrived
+void Simulator::step(std::size_t first, std::size_t last, std::uint64_t* counts) {
+    const std::uint32_t* offsets = graph.get_offsets().data();
+    const std::uint32_t* targets = graph.get_targets().data();
+    if (options.policy == Policy::GREEDY) forage(offsets, targets, food.data(), positions.data(), states.data(), first, last);
+    else walk(offsets, targets, positions.data(), states.data(), first, last);
+
+    for (std::size_t a = first; a < last; a++) {
+        std::uint32_t position = positions[a];
+        counts[position]++;
+        std::atomic_ref<int> here(food[position]);
+        if (here.load(std::memory_order_relaxed) > 0) eaten[a] += here.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Moves every agent a number of times, adding the arrivals to the heatmap.
+ *
+ * Agents are split into contiguous slices, one per thread, and threads meet at
+ * a barrier after every step so all agents move in lockstep. Each thread counts
+ * visits into its own heatmap, merged at the end, so the hot loop shares no
+ * counters. Food is the only shared state: an agent takes all of a Location's
+ * food with one atomic exchange, and which agent wins when several arrive in
+ * the same step depends on thread timing.
+ *
+ * @param steps How many moves each agent makes.
+ */
+void Simulator::run(int steps) {
+    if (steps <= 0 || positions.empty()) return;
+    const std::size_t agents = positions.size();
+    // Slices of at least 4096 agents, kept to multiples of 4 for the SIMD kernel
+    std::size_t thread_count = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::max<std::size_t>(1, std::min(thread_count, agents / 4096));
+    const std::size_t slice = (agents / thread_count + 3) & ~std::size_t(3);
+
+    std::vector<std::vector<std::uint64_t>> counts(thread_count, std::vector<std::uint64_t>(visits.size(), 0));
+    std::barrier sync(static_cast<std::ptrdiff_t>(thread_count));
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t] {
+            std::size_t first = std::min(agents, t * slice);
+            std::size_t last = t + 1 == thread_count ? agents : std::min(agents, first + slice);
+            for (int s = 0; s < steps; s++) {
+                step(first, last, counts[t].data());
+                sync.arrive_and_wait();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (const auto& local : counts) {
+        for (std::size_t i = 0; i < visits.size(); i++) visits[i] += local[i];
+    }
+}
+
+// Results
+const std::vector<std::uint32_t>& Simulator::get_positions() const { return positions; }
+const std::vector<std::uint64_t>& Simulator::get_visits() const { return visits; }
+
+long long Simulator::total_eaten() const {
+    long long total = 0;
+    for (int calories : eaten) total += calories;
+    return total;
+}
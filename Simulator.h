@@ -0,0 +1,56 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ExitGraph;
+class World;
+
+// Batched simulation of many simple agents walking a World's exit graph, for
+// traffic modeling. Agents are columns (position, random state, calories eaten)
+// rather than Games; each step moves every agent once and counts the arrival in
+// a per-Location visit heatmap. Agents eat whatever food they find; the food is
+// a copy of the calories lying in each Location when the Simulator was made.
+class Simulator {
+public:
+    enum class Policy { RANDOM_WALK, GREEDY };
+
+    struct Options {
+        std::size_t agents = 1000000;
+        Policy policy = Policy::RANDOM_WALK;
+        unsigned threads = 0;        // zero means one per hardware thread
+        std::uint32_t seed = 1;
+        int start = -1;              // a Location id, or -1 to spread agents at random
+    };
+
+private:
+    const ExitGraph& graph;
+    Options options;
+
+    // One entry per agent
+    std::vector<std::uint32_t> positions;
+    std::vector<std::uint32_t> states;
+    std::vector<int> eaten;
+
+    // One entry per Location
+    std::vector<int> food;
+    std::vector<std::uint64_t> visits;
+
+    void step(std::size_t first, std::size_t last, std::uint64_t* counts);
+
+public:
+    // Constructor; the World must outlive the Simulator
+    Simulator(const World& world, const Options& options);
+
+    // Moves every agent `steps` times
+    void run(int steps);
+
+    // Results
+    const std::vector<std::uint32_t>& get_positions() const;
+    const std::vector<std::uint64_t>& get_visits() const;
+    long long total_eaten() const;
+};
+
+#endif
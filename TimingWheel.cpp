@@ -0,0 +1,110 @@
+#include "TimingWheel.h"
+
+// Constructor
+TimingWheel::TimingWheel() : free_list(NONE), overflow(NONE), current(0), count(0) {
+    for (auto& level : slots) level.fill(NONE);
+}
+
+// Scheduling
+void TimingWheel::schedule(std::uint64_t delay, std::function<void()> action) {
+    std::uint32_t node;
+    if (free_list != NONE) {
+        node = free_list;
+        free_list = nodes[node].next;
+    } else {
+        node = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node].due = current + (delay == 0 ? 1 : delay);
+    nodes[node].action = std::move(action);
+    place(node);
+    count++;
+}
+
+/**
+ * @brief Links a node into the slot for its due time.
+ *
+ * The level is chosen by how far away the event is: within 64 ticks it goes
+ * straight into level 0, within 64^2 into level 1, and so on.
+ */
+void TimingWheel::place(std::uint32_t node) {
+    std::uint64_t due = nodes[node].due;
+    std::uint64_t distance = due - current;
+    std::uint32_t* head = &overflow;
+    for (int level = 0; level < LEVELS; level++) {
+        if (distance < (std::uint64_t{1} << (BITS * (level + 1)))) {
+            head = &slots[level][(due >> (BITS * level)) & (SLOTS - 1)];
+            break;
+        }
+    }
+    nodes[node].next = *head;
+    *head = node;
+}
+
+void TimingWheel::cascade(int level, std::uint32_t slot) {
+    std::uint32_t node = slots[level][slot];
+    slots[level][slot] = NONE;
+    while (node != NONE) {
+        std::uint32_t next = nodes[node].next;
+        place(node);
+        node = next;
+    }
+}
+
+// Time
+std::size_t TimingWheel::tick() {
+    current++;
+
+    // Each time a lower level wraps, bring the matching slot of the level above down
+    if ((current & (SLOTS - 1)) == 0) {
+        int top = 1;
+        while (top < LEVELS && ((current >> (BITS * top)) & (SLOTS - 1)) == 0) top++;
+        if (top == LEVELS) {
+            std::uint32_t node = overflow;
+            overflow = NONE;
+            while (node != NONE) {
+                std::uint32_t next = nodes[node].next;
+                place(node);
+                node = next;
+            }
+            top = LEVELS - 1;
+        }
+        for (int level = top; level >= 1; level--) {
+            cascade(level, static_cast<std::uint32_t>((current >> (BITS * level)) & (SLOTS - 1)));
+        }
+    }
+
+    std::uint32_t& head = slots[0][current & (SLOTS - 1)];
+    std::uint32_t node = head;
+    head = NONE;
+    std::size_t ran = 0;
+    while (node != NONE) {
+        std::uint32_t next = nodes[node].next;
+        // Free the node before running: the action may schedule and reuse it
+        std::function<void()> action = std::move(nodes[node].action);
+        nodes[node].action = nullptr;
+        nodes[node].next = free_list;
+        free_list = node;
+        count--;
+        action();
+        ran++;
+        node = next;
+    }
+    return ran;
+}
+
+std::size_t TimingWheel::advance(std::uint64_t ticks) {
+    std::size_t ran = 0;
+    for (std::uint64_t i = 0; i < ticks; i++) {
+        if (count == 0) {
+            // Nothing pending: skip the rest of the stretch in one step
+            current += ticks - i;
+            break;
+        }
+        ran += tick();
+    }
+    return ran;
+}
+
+std::uint64_t TimingWheel::now() const { return current; }
+std::size_t TimingWheel::size() const { return count; }
@@ -0,0 +1,54 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timing wheel: four levels of 64 slots cover 2^24 ticks, later
+// events wait in an overflow list. Advancing one tick touches only the events
+// that are due plus, every 64 ticks, one slot cascaded down from a higher level.
+class TimingWheel {
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int BITS = 6;
+    static constexpr std::uint32_t SLOTS = 1u << BITS;
+    static constexpr std::uint32_t NONE = 0xffffffffu;
+
+    // Events live in a pool and are chained through `next`, so a slot is one index
+    struct Node {
+        std::uint64_t due;
+        std::function<void()> action;
+        std::uint32_t next;
+    };
+
+    std::vector<Node> nodes;
+    std::uint32_t free_list;
+    std::array<std::array<std::uint32_t, SLOTS>, LEVELS> slots;
+    std::uint32_t overflow;
+    std::uint64_t current;
+    std::size_t count;
+
+    // Helper methods
+    void place(std::uint32_t node);
+    void cascade(int level, std::uint32_t slot);
+    std::size_t tick();
+
+public:
+    // Constructor
+    TimingWheel();
+
+    // Runs `action` once, `delay` ticks from now (at least one)
+    void schedule(std::uint64_t delay, std::function<void()> action);
+
+    // Moves time forward, running every event that comes due; returns how many ran
+    std::size_t advance(std::uint64_t ticks);
+
+    // Ticks elapsed since construction, and events still waiting
+    std::uint64_t now() const;
+    std::size_t size() const;
+};
+
+#endif
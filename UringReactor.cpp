@@ -0,0 +1,540 @@
+/**
+ * @file UringReactor.cpp
+ * @brief io_uring backend for the GVZork line server.
+ *
+ * Talks to the kernel through the raw io_uring syscalls (no liburing needed).
+ * One multishot accept keeps accepting connections, and each connection has
+ * one multishot recv that draws from a ring of provided buffers registered
+ * with the kernel, so idle connections hold no receive buffer of their own.
+ * Submissions from a whole batch of completions go to the kernel in a single
+ * io_uring_enter, which also waits for the next completions. With hibernation
+ * on, a timeout operation wakes the loop periodically to put idle sessions to sleep.
+ * Sessions running on scheduler workers report replies through the ReadyList,
+ * and the read armed on the wakeup eventfd brings the loop round to send them.
+ */
+
+#include "UringReactor.h"
+#include <iostream>
+
+#ifdef GVZORK_IO_URING
+
+#include "Connection.h"
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    constexpr unsigned SQ_ENTRIES = 4096;
+    constexpr unsigned CQ_ENTRIES = 16384;
+    constexpr unsigned BUFFER_COUNT = 2048;   // power of two
+    constexpr unsigned BUFFER_SIZE = 4096;
+    constexpr unsigned short BUFFER_GROUP = 0;
+
+    // user_data layout: operation in the low byte, descriptor above it
+    enum Operation : std::uint64_t { ACCEPT = 1, RECV, SEND, WAKE, CANCEL, SWEEP };
+    std::uint64_t tag(Operation op, int fd) { return (static_cast<std::uint64_t>(fd) << 8) | op; }
+
+    int io_uring_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int io_uring_register(int fd, unsigned opcode, void* arg, unsigned count) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    unsigned load_acquire(unsigned* p) { return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire); }
+    void store_release(unsigned* p, unsigned v) { std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release); }
+}
+
+class UringReactor : public Server::Reactor {
+private:
+    struct Entry {
+        std::unique_ptr<Connection> connection;
+        std::string sending;        // bytes owned by the kernel until the send completes
+        std::size_t sent = 0;
+        int inflight = 0;           // operations whose final completion has not arrived
+        bool receiving = false;
+        bool cancelling = false;
+        bool sending_now = false;
+        bool closing = false;
+    };
+
+    Server& server;
+    int listen_fd;
+    int wake_fd;
+    std::uint64_t wake_value;
+
+    // Rings shared with the kernel
+    int ring_fd;
+    void* sq_memory;
+    std::size_t sq_memory_size;
+    void* cq_memory;
+    std::size_t cq_memory_size;
+    io_uring_sqe* sqes;
+    std::size_t sqes_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe* cqes;
+    unsigned queued;
+    std::vector<io_uring_cqe> reaped;   // taken off the completion queue, not yet handled
+
+    // Provided receive buffers
+    char* buffers;
+    io_uring_buf* buffer_ring;
+    unsigned short buffer_tail;
+
+    std::unordered_map<int, Entry> connections;
+    ReadyList ready;
+
+    // Hibernation; the timeout is read by the kernel while the sweep is armed
+    std::unique_ptr<SessionArchive> archive;
+    __kernel_timespec sweep_interval;
+
+    // Helper methods
+    void setup();
+    void release();
+    io_uring_sqe* next_sqe();
+    bool submit_and_wait(unsigned min_complete);
+    void reap();
+    void recycle(unsigned short id);
+    void arm_accept();
+    void arm_wake();
+    void arm_sweep();
+    void sweep();
+    void service_ready();
+    void arm_recv(int fd, Entry& entry);
+    void start_send(int fd, Entry& entry);
+    void service(int fd, Entry& entry);
+    void finish_op(int fd, Entry& entry);
+    void close_connection(int fd, Entry& entry);
+    void complete(const io_uring_cqe& cqe);
+
+public:
+    UringReactor(Server& server, int listen_fd);
+    ~UringReactor() override;
+    void run() override;
+    void wake() override;
+};
+
+// Constructor; throws std::system_error (leaving `listen_fd` open) if the kernel refuses any step
+UringReactor::UringReactor(Server& server, int listen_fd)
+    : server(server), listen_fd(listen_fd), wake_fd(-1), wake_value(0), ring_fd(-1), sq_memory(MAP_FAILED),
+      sq_memory_size(0), cq_memory(MAP_FAILED), cq_memory_size(0), sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqes_size(0), queued(0), buffers(nullptr), buffer_ring(static_cast<io_uring_buf*>(MAP_FAILED)),
+      buffer_tail(0), ready([this] { wake(); }), sweep_interval{} {
+    try {
+        setup();
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+UringReactor::~UringReactor() {
+    for (auto& [fd, entry] : connections) close(fd);
+    close(listen_fd);
+    release();
+}
+
+void UringReactor::release() {
+    if (wake_fd >= 0) close(wake_fd);
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    if (sq_memory != MAP_FAILED) munmap(sq_memory, sq_memory_size);
+    if (ring_fd >= 0) close(ring_fd);
+    if (buffer_ring != MAP_FAILED) munmap(buffer_ring, BUFFER_COUNT * sizeof(io_uring_buf));
+    delete[] buffers;
+}
+
+/**
+ * @brief Creates the rings, maps them, and registers the receive buffers.
+ *
+ * The ring starts disabled and is enabled by run(), because a single-issuer
+ * ring belongs to the thread that enables it and reactors run on their own threads.
+ */
+void UringReactor::setup() {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER |
+                   IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_R_DISABLED;
+    params.cq_entries = CQ_ENTRIES;
+    ring_fd = io_uring_setup(SQ_ENTRIES, &params);
+    if (ring_fd < 0 && errno == EINVAL) {
+        // Older kernels: no single-issuer / deferred task work
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED;
+        params.cq_entries = CQ_ENTRIES;
+        ring_fd = io_uring_setup(SQ_ENTRIES, &params);
+    }
+    if (ring_fd < 0) throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        throw std::system_error(ENOTSUP, std::generic_category(), "io_uring features");
+    }
+
+    auto map = [this](std::size_t size, off_t offset) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        if (memory == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap io_uring");
+        return memory;
+    };
+    sq_memory_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    sq_memory = map(sq_memory_size, IORING_OFF_SQ_RING);
+    cq_memory = sq_memory;
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(map(sqes_size, IORING_OFF_SQES));
+
+    char* sq = static_cast<char*>(sq_memory);
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_memory);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Register the receive buffer ring; the kernel picks a buffer per received chunk
+    void* ring_memory = mmap(nullptr, BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring_memory == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap buffer ring");
+    buffer_ring = static_cast<io_uring_buf*>(ring_memory);
+    buffers = new char[static_cast<std::size_t>(BUFFER_COUNT) * BUFFER_SIZE];
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<std::uint64_t>(ring_memory);
+    registration.ring_entries = BUFFER_COUNT;
+    registration.bgid = BUFFER_GROUP;
+    if (io_uring_register(ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        throw std::system_error(errno, std::generic_category(), "IORING_REGISTER_PBUF_RING");
+    }
+    for (unsigned id = 0; id < BUFFER_COUNT; id++) recycle(static_cast<unsigned short>(id));
+
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd < 0) throw std::system_error(errno, std::generic_category(), "eventfd");
+    arm_accept();
+    arm_wake();
+    archive = server.make_archive();
+    if (archive) {
+        auto interval = server.get_sweep_interval();
+        sweep_interval.tv_sec = interval.count() / 1000;
+        sweep_interval.tv_nsec = (interval.count() % 1000) * 1000000;
+        arm_sweep();
+    }
+}
+
+// Submission queue
+/**
+ * @brief Claims the next submission queue entry, zeroed.
+ *
+ * When the queue is full, what is queued goes to the kernel first. The kernel
+ * refuses while completions it could not post are backed up, so those are
+ * reaped (to be handled by the event loop as usual) before trying again.
+ */
+io_uring_sqe* UringReactor::next_sqe() {
+    unsigned tail = *sq_tail;
+    while (tail - load_acquire(sq_head) > sq_mask) {
+        if (!submit_and_wait(0)) reap();
+    }
+    unsigned index = tail & sq_mask;
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    store_release(sq_tail, tail + 1);
+    queued++;
+    return sqe;
+}
+
+// False if the kernel took nothing because the completion queue is backed up; reap before trying again
+bool UringReactor::submit_and_wait(unsigned min_complete) {
+    while (true) {
+        int result = io_uring_enter(ring_fd, queued, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (result >= 0) {
+            queued -= std::min<unsigned>(queued, static_cast<unsigned>(result));
+            return true;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EBUSY) return false;
+        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+    }
+}
+
+// Copies every posted completion out and releases its slot, so the kernel can post more
+void UringReactor::reap() {
+    unsigned head = *cq_head;
+    unsigned tail = load_acquire(cq_tail);
+    while (head != tail) {
+        reaped.push_back(cqes[head & cq_mask]);
+        head++;
+    }
+    store_release(cq_head, head);
+}
+
+// Buffer ring; its tail lives in the reserved field of the first entry
+void UringReactor::recycle(unsigned short id) {
+    io_uring_buf& buffer = buffer_ring[buffer_tail & (BUFFER_COUNT - 1)];
+    buffer.addr = reinterpret_cast<std::uint64_t>(buffers + static_cast<std::size_t>(id) * BUFFER_SIZE);
+    buffer.len = BUFFER_SIZE;
+    buffer.bid = id;
+    buffer_tail++;
+    std::atomic_ref<unsigned short>(buffer_ring[0].resv).store(buffer_tail, std::memory_order_release);
+}
+
+// Operations
+void UringReactor::arm_accept() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = tag(ACCEPT, listen_fd);
+}
+
+void UringReactor::arm_wake() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&wake_value);
+    sqe->len = sizeof(wake_value);
+    sqe->user_data = tag(WAKE, wake_fd);
+}
+
+void UringReactor::arm_sweep() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&sweep_interval);
+    sqe->len = 1;
+    sqe->user_data = tag(SWEEP, 0);
+}
+
+void UringReactor::arm_recv(int fd, Entry& entry) {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = tag(RECV, fd);
+    entry.receiving = true;
+    entry.inflight++;
+}
+
+void UringReactor::start_send(int fd, Entry& entry) {
+    if (!entry.sending_now) {
+        std::string_view pending = entry.connection->pending_output();
+        if (pending.empty()) return;
+        entry.sending.assign(pending);
+        entry.connection->consume_output(pending.size());
+        entry.sent = 0;
+        entry.sending_now = true;
+    }
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(entry.sending.data() + entry.sent);
+    sqe->len = static_cast<unsigned>(entry.sending.size() - entry.sent);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = tag(SEND, fd);
+    entry.inflight++;
+}
+
+/**
+ * @brief Runs buffered lines and brings the connection's operations in line with its state.
+ *
+ * Starts a send when output is waiting and none is in flight, and cancels the
+ * multishot recv while the output backlog is over the watermark (backpressure),
+ * re-arming it once the client catches up.
+ */
+void UringReactor::service(int fd, Entry& entry) {
+    if (entry.closing) return;
+    entry.connection->process();
+    if (!entry.sending_now) start_send(fd, entry);
+    if (entry.connection->finished() && !entry.sending_now) {
+        close_connection(fd, entry);
+        return;
+    }
+    if (entry.connection->wants_input()) {
+        if (!entry.receiving) arm_recv(fd, entry);
+    } else if (entry.receiving && !entry.cancelling) {
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = tag(RECV, fd);
+        sqe->user_data = tag(CANCEL, fd);
+        entry.cancelling = true;
+    }
+}
+
+// Hibernates connections that have been idle long enough; their multishot recv stays armed
+void UringReactor::sweep() {
+    auto idle_since = std::chrono::steady_clock::now() - server.get_hibernate_after();
+    std::size_t hibernated = 0;
+    for (auto& [fd, entry] : connections) {
+        if (!entry.closing && !entry.sending_now) hibernated += entry.connection->hibernate(idle_since);
+    }
+    if (hibernated > 0) Server::release_memory();
+}
+
+// The wakeup has been read by now, so a session reported after this wakes the loop again
+void UringReactor::service_ready() {
+    for (auto& [fd, session] : ready.take()) {
+        auto found = connections.find(fd);
+        if (found != connections.end() && found->second.connection->get_session() == session.get()) {
+            service(fd, found->second);
+        }
+    }
+}
+
+// Connections are only closed once the kernel has finished every operation on them
+void UringReactor::close_connection(int fd, Entry& entry) {
+    entry.closing = true;
+    if (entry.receiving && !entry.cancelling) {
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = tag(CANCEL, fd);
+        entry.cancelling = true;
+    }
+    finish_op(fd, entry);
+}
+
+void UringReactor::finish_op(int fd, Entry& entry) {
+    if (entry.closing && entry.inflight == 0) {
+        close(fd);
+        connections.erase(fd);
+    }
+}
+
+// Completions
+void UringReactor::complete(const io_uring_cqe& cqe) {
+    auto op = static_cast<Operation>(cqe.user_data & 0xff);
+    int fd = static_cast<int>(cqe.user_data >> 8);
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    if (op == CANCEL) return;
+    if (op == WAKE) {
+        service_ready();
+        if (!server.is_stopping()) arm_wake();
+        return;
+    }
+    if (op == SWEEP) {
+        sweep();
+        if (!server.is_stopping()) arm_sweep();
+        return;
+    }
+    if (op == ACCEPT) {
+        if (cqe.res >= 0) {
+            Entry& entry = connections[cqe.res];
+            entry.connection = std::make_unique<Connection>(cqe.res, server.get_host(), archive.get(), server.get_journal(),
+                                                            server.get_scheduler(), ready.notifier(cqe.res));
+            service(cqe.res, entry);
+        } else if (cqe.res != -EAGAIN && cqe.res != -ECONNABORTED) {
+            std::cerr << "accept: " << std::strerror(-cqe.res) << "\n";
+        }
+        if (!more) arm_accept();
+        return;
+    }
+
+    auto found = connections.find(fd);
+    if (found == connections.end()) return;
+    Entry& entry = found->second;
+
+    if (op == RECV) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            auto id = static_cast<unsigned short>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && !entry.closing &&
+                !entry.connection->receive(buffers + static_cast<std::size_t>(id) * BUFFER_SIZE,
+                                           static_cast<std::size_t>(cqe.res))) {
+                close_connection(fd, entry);
+            }
+            recycle(id);
+        }
+        if (!more) {
+            entry.receiving = false;
+            entry.cancelling = false;
+            entry.inflight--;
+        }
+        if (cqe.res == 0) {
+            entry.connection->end_of_input();
+        } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED && !entry.closing) {
+            close_connection(fd, entry);
+            return;
+        }
+    } else if (op == SEND) {
+        entry.inflight--;
+        if (cqe.res < 0) {
+            if (!entry.closing) close_connection(fd, entry);
+            else finish_op(fd, entry);
+            return;
+        }
+        entry.sent += static_cast<std::size_t>(cqe.res);
+        if (entry.sent < entry.sending.size() && !entry.closing) {
+            start_send(fd, entry);
+            return;
+        }
+        entry.sending.clear();
+        entry.sending_now = false;
+    }
+
+    if (entry.closing) finish_op(fd, entry);
+    else service(fd, entry);
+}
+
+// Event loop
+void UringReactor::run() {
+    if (io_uring_register(ring_fd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0) < 0) {
+        throw std::system_error(errno, std::generic_category(), "IORING_REGISTER_ENABLE_RINGS");
+    }
+    reaped.reserve(CQ_ENTRIES);
+    while (!server.is_stopping()) {
+        submit_and_wait(1);
+        reap();
+        // Handling a completion can reap more (see next_sqe), which land at the end
+        for (std::size_t i = 0; i < reaped.size(); i++) {
+            io_uring_cqe cqe = reaped[i];
+            complete(cqe);
+            if (i + 1 == reaped.size()) reap();
+        }
+        reaped.clear();
+    }
+}
+
+void UringReactor::wake() {
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd, &one, sizeof(one));
+}
+
+std::unique_ptr<Server::Reactor> make_uring_reactor(Server& server, int listen_fd) {
+    try {
+        return std::make_unique<UringReactor>(server, listen_fd);
+    } catch (const std::system_error& error) {
+        std::cerr << "io_uring unavailable (" << error.what() << "), using epoll\n";
+        return nullptr;
+    }
+}
+
+#else
+
+std::unique_ptr<Server::Reactor> make_uring_reactor(Server&, int) {
+    std::cerr << "Built without io_uring support, using epoll\n";
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef URINGREACTOR_H
+#define URINGREACTOR_H
+
+#include <memory>
+#include "Server.h"
+
+// Creates an io_uring reactor for `listen_fd`, or returns nullptr (after saying
+// why on std::cerr) when io_uring is not compiled in or the kernel refuses it,
+// so the caller can fall back to epoll. The listening socket stays owned by the
+// caller on failure.
+std::unique_ptr<Server::Reactor> make_uring_reactor(Server& server, int listen_fd);
+
+#endif
@@ -0,0 +1,200 @@
+#include "Validator.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <thread>
+#include "World.h"
+
+namespace {
+
+// Frontier entries handed out per grab, and the smallest graph worth threads for
+constexpr std::size_t CHUNK = 1024;
+constexpr std::size_t PARALLEL_SIZE = 1 << 16;
+
+// Runs `body(first, last, worker)` over contiguous slices of [0, count)
+template <typename Body>
+void parallel_for(std::size_t count, std::size_t workers, Body body) {
+    std::size_t slice = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < workers; t++) {
+        threads.emplace_back([&, t] { body(std::min(count, t * slice), std::min(count, (t + 1) * slice), t); });
+    }
+    body(0, std::min(count, slice), 0);
+    for (auto& thread : threads) thread.join();
+}
+
+}
+
+// Constructor; builds the reversed exits with a counting sort
+Validator::Validator(const ExitGraph& graph, unsigned threads) : graph(graph), threads(threads) {
+    if (this->threads == 0) this->threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto& offsets = graph.get_offsets();
+    const auto& targets = graph.get_targets();
+    reverse_offsets.assign(graph.size() + 1, 0);
+    for (std::uint32_t target : targets) reverse_offsets[target + 1]++;
+    for (std::size_t i = 1; i < reverse_offsets.size(); i++) reverse_offsets[i] += reverse_offsets[i - 1];
+    reverse_targets.resize(targets.size());
+    std::vector<std::uint32_t> next(reverse_offsets.begin(), reverse_offsets.end() - 1);
+    for (std::uint32_t location = 0; location < graph.size(); location++) {
+        for (std::uint32_t e = offsets[location]; e < offsets[location + 1]; e++) reverse_targets[next[targets[e]]++] = location;
+    }
+}
+
+/**
+ * @brief Breadth-first search from a set of Locations, level by level in parallel.
+ *
+ * Workers take chunks of the current frontier from a shared cursor and claim
+ * unseen neighbors with an atomic exchange on their mark, so each Location
+ * enters exactly one worker's next frontier. At the barrier between levels one
+ * worker joins those into the new frontier. Small graphs are searched on the
+ * calling thread alone.
+ *
+ * @param offsets The graph's CSR offsets.
+ * @param targets The graph's CSR targets.
+ * @param start The Locations to search from.
+ * @return One mark per Location, 1 where reached.
+ */
+std::vector<std::uint8_t> Validator::search(const std::uint32_t* offsets, const std::uint32_t* targets,
+                                            const std::vector<std::uint32_t>& start) const {
+    const std::size_t size = graph.size();
+    std::vector<std::uint8_t> seen(size, 0);
+    std::vector<std::uint32_t> frontier;
+    for (std::uint32_t location : start) {
+        if (location >= size || seen[location]) continue;
+        seen[location] = 1;
+        frontier.push_back(location);
+    }
+
+    const std::size_t workers = size < PARALLEL_SIZE ? 1 : threads;
+    std::vector<std::vector<std::uint32_t>> next(workers);
+    std::atomic<std::size_t> cursor{0};
+    auto join_frontiers = [&]() noexcept {
+        frontier.clear();
+        for (auto& local : next) {
+            frontier.insert(frontier.end(), local.begin(), local.end());
+            local.clear();
+        }
+        cursor.store(0, std::memory_order_relaxed);
+    };
+    std::barrier sync(static_cast<std::ptrdiff_t>(workers), join_frontiers);
+
+    auto work = [&](std::size_t worker) {
+        while (!frontier.empty()) {
+            for (;;) {
+                std::size_t first = cursor.fetch_add(CHUNK, std::memory_order_relaxed);
+                if (first >= frontier.size()) break;
+                std::size_t last = std::min(frontier.size(), first + CHUNK);
+                for (std::size_t i = first; i < last; i++) {
+                    std::uint32_t location = frontier[i];
+                    for (std::uint32_t e = offsets[location]; e < offsets[location + 1]; e++) {
+                        std::atomic_ref<std::uint8_t> mark(seen[targets[e]]);
+                        if (mark.load(std::memory_order_relaxed)) continue;
+                        if (mark.exchange(1, std::memory_order_relaxed) == 0) next[worker].push_back(targets[e]);
+                    }
+                }
+            }
+            sync.arrive_and_wait();
+        }
+    };
+    std::vector<std::thread> helpers;
+    for (std::size_t worker = 1; worker < workers; worker++) helpers.emplace_back(work, worker);
+    work(0);
+    for (auto& helper : helpers) helper.join();
+    return seen;
+}
+
+std::vector<std::uint8_t> Validator::reachable_from(const std::vector<std::uint32_t>& start) const {
+    return search(graph.get_offsets().data(), graph.get_targets().data(), start);
+}
+
+std::vector<std::uint8_t> Validator::reaching(const std::vector<std::uint32_t>& goal) const {
+    return search(reverse_offsets.data(), reverse_targets.data(), goal);
+}
+
+std::vector<std::pair<std::uint32_t, std::uint32_t>> Validator::one_way_exits() const {
+    const std::uint32_t* offsets = graph.get_offsets().data();
+    const std::uint32_t* targets = graph.get_targets().data();
+    const std::size_t workers = graph.size() < PARALLEL_SIZE ? 1 : threads;
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> found(workers);
+    parallel_for(graph.size(), workers, [&](std::size_t first, std::size_t last, std::size_t worker) {
+        for (std::size_t from = first; from < last; from++) {
+            for (std::uint32_t e = offsets[from]; e < offsets[from + 1]; e++) {
+                std::uint32_t to = targets[e];
+                const std::uint32_t* back = std::find(targets + offsets[to], targets + offsets[to + 1], from);
+                if (back == targets + offsets[to + 1]) found[worker].emplace_back(static_cast<std::uint32_t>(from), to);
+            }
+        }
+    });
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> result;
+    for (const auto& local : found) result.insert(result.end(), local.begin(), local.end());
+    return result;
+}
+
+std::vector<std::uint32_t> Validator::dead_ends() const {
+    const auto& offsets = graph.get_offsets();
+    std::vector<std::uint32_t> result;
+    for (std::uint32_t location = 0; location < graph.size(); location++) {
+        if (offsets[location] == offsets[location + 1]) result.push_back(location);
+    }
+    return result;
+}
+
+/**
+ * @brief Checks that a World can be won from anywhere a player may start.
+ *
+ * The start set is every Location where the rules feed the Elf for giving food
+ * in general (rules written for one Item are not considered). Players start at
+ * random, so a Location that cannot lead back to the start set strands them;
+ * one the start set cannot reach is only wasted. Food counts toward the goal
+ * when its Location is reachable both ways and it fits under the carry limit.
+ * The goal is achievable if that food covers it outright, or if respawning it
+ * outpaces hunger so every round trip gains ground (travel time aside).
+ *
+ * @param world The World to check.
+ * @param carry_limit The most weight a player may carry, in pounds.
+ * @param threads Worker threads for the searches; zero means one per hardware thread.
+ * @return Everything found.
+ */
+Validator::Report Validator::validate(const World& world, float carry_limit, unsigned threads) {
+    Report report{};
+    Validator validator(world.get_exit_graph(), threads);
+    const std::size_t size = world.get_locations().size();
+
+    const std::string any_item;
+    for (std::uint32_t location = 0; location < size; location++) {
+        const RuleBook::Rule* rule =
+            world.get_rule_table().find(RuleBook::Action::GIVE, any_item, static_cast<int>(location), true);
+        if (!rule) continue;
+        for (const auto& effect : rule->effects) {
+            if (effect.kind != RuleBook::Effect::Kind::FEED) continue;
+            report.feeding.push_back(location);
+            break;
+        }
+    }
+
+    std::vector<std::uint8_t> reached = validator.reachable_from(report.feeding);
+    std::vector<std::uint8_t> returns = validator.reaching(report.feeding);
+    for (std::uint32_t location = 0; location < size; location++) {
+        if (!reached[location]) report.unreachable.push_back(location);
+        if (!returns[location]) report.stranded.push_back(location);
+    }
+    report.dead_ends = validator.dead_ends();
+    report.one_way = validator.one_way_exits();
+
+    world.get_entities().for_each([&](std::uint32_t, std::int32_t owner, std::string_view name, int calories,
+                                      float weight) {
+        if (calories <= 0) return;
+        auto location = static_cast<std::uint32_t>(owner);
+        if (!reached[location] || !returns[location]) report.unreachable_food.push_back({location, std::string(name), calories});
+        else if (weight > carry_limit) report.heavy_food.push_back({location, std::string(name), calories});
+        else report.deliverable_calories += calories;
+    });
+    report.calories_needed = world.get_calories_needed() - world.get_rules().get_win_at();
+    report.goal_achievable = report.deliverable_calories >= report.calories_needed ||
+                             report.deliverable_calories * World::HUNGER_TICKS > World::HUNGER_CALORIES * World::RESPAWN_TICKS;
+    return report;
+}
+
+bool Validator::Report::has_errors() const {
+    return feeding.empty() || !stranded.empty() || !dead_ends.empty() || !goal_achievable;
+}
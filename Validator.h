@@ -0,0 +1,65 @@
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ExitGraph;
+class World;
+
+// Checks a World's layout for mistakes designers make with Location::add_location:
+// rooms the player can never reach or never leave, exits without a way back,
+// rooms with no exits at all, and food that can never be delivered. Searches run
+// level by level with the frontier split across threads.
+class Validator {
+public:
+    struct Food {
+        std::uint32_t location;
+        std::string name;
+        int calories;
+    };
+
+    struct Report {
+        std::vector<std::uint32_t> feeding;        // where giving food feeds the Elf: the start set
+        std::vector<std::uint32_t> unreachable;    // no path from the start set
+        std::vector<std::uint32_t> stranded;       // no path back to the start set
+        std::vector<std::uint32_t> dead_ends;      // no exits at all
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> one_way;
+        std::vector<Food> unreachable_food;        // cannot be fetched and brought back
+        std::vector<Food> heavy_food;              // over the carry limit
+        long long deliverable_calories;
+        int calories_needed;
+        bool goal_achievable;
+
+        // Problems that make the game unwinnable for some players
+        bool has_errors() const;
+    };
+
+private:
+    const ExitGraph& graph;
+    std::vector<std::uint32_t> reverse_offsets;
+    std::vector<std::uint32_t> reverse_targets;
+    unsigned threads;
+
+    std::vector<std::uint8_t> search(const std::uint32_t* offsets, const std::uint32_t* targets,
+                                     const std::vector<std::uint32_t>& start) const;
+
+public:
+    // Constructor; zero threads means one per hardware thread
+    explicit Validator(const ExitGraph& graph, unsigned threads = 0);
+
+    // Marks (1 or 0 per Location) where the start set can get to, and what can get to it
+    std::vector<std::uint8_t> reachable_from(const std::vector<std::uint32_t>& start) const;
+    std::vector<std::uint8_t> reaching(const std::vector<std::uint32_t>& goal) const;
+
+    // Exits whose target has no exit back, in order of origin
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> one_way_exits() const;
+    std::vector<std::uint32_t> dead_ends() const;
+
+    // Runs every check on a World
+    static Report validate(const World& world, float carry_limit, unsigned threads = 0);
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include "World.h"
+#include "Bytes.h"
+#include <algorithm>
+#include <iterator>
+
+// Constructor
+World::World(std::shared_ptr<const RuleBook> rules, std::shared_ptr<const WorldTemplate> content)
+    : rules(std::move(rules)), content(std::move(content)), calories_needed(this->rules->get_goal()), calorie_goal(this->rules->get_goal()),
+      epoch(std::chrono::steady_clock::now()), rng(std::random_device{}()) {
+    create_world();
+    rule_table = RuleBook::bind(this->rules, locations);
+    search_index = SearchIndex::build(locations);
+    exit_graph = ExitGraph(locations);
+}
+
+/**
+ * @brief Creates the game world with Locations, NPCs, and Items.
+ *
+ * This method instantiates the World's content: Locations in template order
+ * (so a Location's id is its index in the template), then the exits between
+ * them, the NPCs, and the Items. Wandering NPCs and the Elf's hunger are
+ * scheduled on the timing wheel.
+ */
+void World::create_world() {
+    // Locations are stored first so neighbor pointers and ids refer into `locations`
+    locations.reserve(content->get_places().size());
+    for (const auto& place : content->get_places()) locations.emplace_back(place.name, place.description);
+    for (std::size_t id = 0; id < locations.size(); id++) locations[id].attach(&entities, static_cast<std::int32_t>(id));
+
+    // Add neighbors
+    for (const auto& exit : content->get_exits()) locations[exit.from].add_location(exit.direction, &locations[exit.to]);
+
+    // Add NPCs; copies share their compiled dialogue with the template
+    for (const auto& character : content->get_npcs()) {
+        Location* home = &locations[character.location];
+        home->add_npc(character.npc);
+        std::string name = character.npc.get_name();
+        std::uint64_t period = character.wander_ticks;
+        if (period) wheel.schedule(period, [this, name, home, period] { wander(name, home, period); });
+    }
+
+    // Add Items
+    for (const auto& placement : content->get_items()) locations[placement.location].add_item(placement.item);
+
+    // The Elf keeps getting hungrier
+    wheel.schedule(HUNGER_TICKS, [this] { grow_hunger(); });
+}
+
+// Location access
+std::vector<Location>& World::get_locations() { return locations; }
+const std::vector<Location>& World::get_locations() const { return locations; }
+int World::location_id(const Location* location) const { return static_cast<int>(location - locations.data()); }
+
+const WorldTemplate& World::get_content() const { return *content; }
+
+Location* World::find_location(const std::string& name) {
+    int id = content->find_place(name);
+    return id < 0 ? nullptr : &locations[static_cast<std::size_t>(id)];
+}
+
+// Entities
+const EntityStore& World::get_entities() const { return entities; }
+long long World::available_calories() const { return entities.total_calories(); }
+
+// Locking
+std::mutex& World::lock_for(const Location* location) const {
+    return shards[static_cast<std::size_t>(location_id(location)) % SHARDS];
+}
+
+// Goal tracking
+int World::get_calories_needed() const { return calories_needed.load(); }
+int World::feed(int calories) { return calories_needed.fetch_sub(calories) - calories; }
+bool World::is_won() const { return calories_needed.load() <= rules->get_win_at(); }
+
+// Calories already given carry over; a changed goal moves what is still needed with it
+void World::continue_from(const World& previous) {
+    int given = previous.calorie_goal - previous.get_calories_needed();
+    calories_needed.store(std::min(calorie_goal, calorie_goal - given));
+}
+
+/**
+ * @brief Writes the progress a rebuilt World should start from.
+ *
+ * That is the calories given to the Elf and the names of the visited
+ * Locations; Items and NPCs are not saved, since they respawn and wander anyway.
+ *
+ * @param out Receives the bytes (appended).
+ */
+void World::save_progress(std::string& out) const {
+    ByteWriter writer(out);
+    writer.put<std::int32_t>(calorie_goal - get_calories_needed());
+    std::uint32_t visited = 0;
+    for (const auto& location : locations) visited += location.get_visited();
+    writer.put<std::uint32_t>(visited);
+    for (const auto& location : locations) {
+        if (location.get_visited()) writer.put_text(location.get_name());
+    }
+}
+
+/**
+ * @brief Takes over progress written by save_progress, possibly by another process.
+ *
+ * The Elf kept getting hungry while nobody was playing, as it would have in
+ * the World that wrote the progress, so `idle` worth of hunger is added back.
+ * Visited Locations are matched by name.
+ *
+ * @param saved Bytes from save_progress.
+ * @param idle How long ago they were written.
+ * @throws std::invalid_argument If the bytes are not saved progress.
+ */
+void World::restore_progress(std::string_view saved, std::chrono::system_clock::duration idle) {
+    ByteReader reader(saved, "Saved progress is corrupt.");
+    int given = reader.get<std::int32_t>();
+    std::vector<std::string> visited(reader.get<std::uint32_t>());
+    for (auto& name : visited) name = reader.text();
+    if (!reader.at_end()) throw std::invalid_argument("Saved progress is corrupt.");
+
+    if (calorie_goal - given > rules->get_win_at() && idle > idle.zero()) {
+        auto hungers = static_cast<std::uint64_t>(idle / TICK) / HUNGER_TICKS;
+        given -= static_cast<int>(std::min<std::uint64_t>(hungers * HUNGER_CALORIES, std::max(given, 0)));
+    }
+    calories_needed.store(std::min(calorie_goal, calorie_goal - given));
+    for (const auto& name : visited) {
+        if (Location* location = find_location(name)) location->set_visited();
+    }
+}
+
+// Search
+const SearchIndex& World::get_search_index() const { return search_index; }
+
+// Exits
+const ExitGraph& World::get_exit_graph() const { return exit_graph; }
+
+// Attribute queries
+/**
+ * @brief Notes a Location's current Items for the next attribute query.
+ *
+ * Nothing is kept while there is no index, since the next query builds one
+ * from scratch anyway; if changes pile up with nobody querying, the index is
+ * dropped so they stop costing memory.
+ *
+ * @param location The Location whose Items changed; the caller holds its lock.
+ */
+void World::items_changed(const Location* location) {
+    std::lock_guard<std::mutex> lock(item_index_mutex);
+    if (!item_index) return;
+    if (item_changes.size() >= MAX_ITEM_CHANGES) {
+        item_index.reset();
+        item_changes.clear();
+        return;
+    }
+    item_changes.push_back({static_cast<std::uint32_t>(location_id(location)), location->get_items()});
+}
+
+/**
+ * @brief Returns an index of the Items as they are now.
+ *
+ * Changes since the last call are laid over the previous index, which costs
+ * only the changed Locations' Items. The columns are rebuilt once the overlay
+ * grows past a sixteenth of them, so queries stay close to column speed.
+ */
+std::shared_ptr<const ItemIndex> World::get_item_index() const {
+    std::lock_guard<std::mutex> lock(item_index_mutex);
+    if (item_index && !item_changes.empty()) {
+        if (item_index->change_count() + item_changes.size() > item_index->column_size() / 16 + 64) {
+            item_index.reset();
+        } else {
+            item_index = std::make_shared<const ItemIndex>(*item_index, item_changes);
+        }
+        item_changes.clear();
+    }
+    if (!item_index) item_index = std::make_shared<const ItemIndex>(*this);
+    return item_index;
+}
+
+// Rules
+const RuleBook& World::get_rules() const { return *rules; }
+const RuleBook::Table& World::get_rule_table() const { return rule_table; }
+
+const RuleBook::Rule* World::find_rule(RuleBook::Action action, const Item& item, const Location* location) const {
+    return rule_table.find(action, item.get_name(), location_id(location), item.get_calories() > 0);
+}
+
+// Simulation
+std::uint64_t World::tick_at(std::chrono::steady_clock::time_point time) const {
+    if (time <= epoch) return 0;
+    return static_cast<std::uint64_t>((time - epoch) / TICK);
+}
+
+void World::schedule(std::uint64_t delay, std::function<void()> action) {
+    std::uint64_t due = tick_at(std::chrono::steady_clock::now()) + delay;
+    std::lock_guard<std::mutex> lock(incoming_mutex);
+    incoming.emplace_back(due, std::move(action));
+}
+
+/**
+ * @brief Runs every world event that came due since the last call.
+ *
+ * Time is only looked at when a session does something, so an idle World costs
+ * nothing; when a player returns, the wheel catches up and the work done is
+ * proportional to the events that fell due, not to the size of the World.
+ * Events scheduled since the last call are moved into the wheel first; recurring
+ * events reschedule themselves on the wheel directly, so a long catch-up replays
+ * them at the right ticks.
+ *
+ * @param now The time to catch up to.
+ */
+void World::advance(std::chrono::steady_clock::time_point now) {
+    std::unique_lock<std::mutex> lock(wheel_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+    std::vector<std::pair<std::uint64_t, std::function<void()>>> arrived;
+    {
+        std::lock_guard<std::mutex> incoming_lock(incoming_mutex);
+        arrived.swap(incoming);
+    }
+    for (auto& [due, action] : arrived) {
+        wheel.schedule(due > wheel.now() ? due - wheel.now() : 1, std::move(action));
+    }
+    std::uint64_t target = tick_at(now);
+    if (target > wheel.now()) wheel.advance(target - wheel.now());
+}
+
+/**
+ * @brief Arranges for a taken Item to reappear where it was found.
+ *
+ * The Item comes back after RESPAWN_TICKS unless one of the same name is already
+ * there again (for example because the take was undone).
+ *
+ * @param origin The Location the Item was taken from.
+ * @param item The Item that was taken.
+ */
+void World::item_taken(Location* origin, const Item& item) {
+    schedule(RESPAWN_TICKS, [this, origin, item] {
+        std::lock_guard<std::mutex> lock(lock_for(origin));
+        if (origin->find_item(item.get_name())) return;
+        origin->add_item(item);
+        items_changed(origin);
+    });
+}
+
+/**
+ * @brief Moves an NPC to a random neighboring Location and schedules its next move.
+ *
+ * @param npc The NPC's name.
+ * @param location Where the NPC is now.
+ * @param period Ticks between moves.
+ */
+void World::wander(const std::string& npc, Location* location, std::uint64_t period) {
+    std::map<std::string, Location*> exits = location->get_locations();
+    Location* next = location;
+    if (!exits.empty()) {
+        std::uniform_int_distribution<std::size_t> pick(0, exits.size() - 1);
+        next = std::next(exits.begin(), static_cast<std::ptrdiff_t>(pick(rng)))->second;
+    }
+    if (next != location) {
+        std::mutex& from_lock = lock_for(location);
+        std::mutex& to_lock = lock_for(next);
+        std::unique_lock<std::mutex> first(from_lock, std::defer_lock);
+        std::unique_lock<std::mutex> second(to_lock, std::defer_lock);
+        if (&from_lock == &to_lock) first.lock();
+        else std::lock(first, second);
+        std::optional<NPC> moved = location->remove_npc(npc);
+        if (!moved) return;
+        next->add_npc(*moved);
+    }
+    wheel.schedule(period, [this, npc, next, period] { wander(npc, next, period); });
+}
+
+// The Elf's goal creeps back up to where it started while the game is still on
+void World::grow_hunger() {
+    int needed = calories_needed.load();
+    if (is_won()) return;
+    while (needed < calorie_goal &&
+           !calories_needed.compare_exchange_weak(needed, std::min(calorie_goal, needed + HUNGER_CALORIES))) {
+        if (needed <= rules->get_win_at()) return;
+    }
+    wheel.schedule(HUNGER_TICKS, [this] { grow_hunger(); });
+}
@@ -0,0 +1,134 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "EntityStore.h"
+#include "ExitGraph.h"
+#include "ItemIndex.h"
+#include "Location.h"
+#include "RuleBook.h"
+#include "SearchIndex.h"
+#include "TimingWheel.h"
+#include "WorldTemplate.h"
+
+// The shared part of the game: Locations, their contents, and the Elf's goal,
+// built from an immutable WorldTemplate. Several Game sessions may play in one
+// World concurrently.
+class World {
+public:
+    // World time advances in fixed ticks; events are scheduled in ticks
+    static constexpr std::chrono::milliseconds TICK{100};
+    static constexpr std::uint64_t RESPAWN_TICKS = 1200;
+    static constexpr std::uint64_t HUNGER_TICKS = 300;
+    static constexpr int HUNGER_CALORIES = 10;
+
+private:
+    static constexpr std::size_t SHARDS = 64;
+    static constexpr std::size_t MAX_ITEM_CHANGES = 4096;   // unqueried changes kept before the index is dropped
+
+    EntityStore entities;
+    std::vector<Location> locations;
+    std::shared_ptr<const RuleBook> rules;
+    std::shared_ptr<const WorldTemplate> content;
+    RuleBook::Table rule_table;
+    SearchIndex search_index;
+    ExitGraph exit_graph;
+    std::atomic<int> calories_needed;
+    int calorie_goal;
+    mutable std::array<std::mutex, SHARDS> shards;
+
+    // Attribute index over the Items; Locations whose Items changed since it was
+    // last brought up to date wait in item_changes
+    mutable std::mutex item_index_mutex;
+    mutable std::shared_ptr<const ItemIndex> item_index;
+    mutable std::vector<ItemIndex::Change> item_changes;
+
+    // Simulation state; the wheel and rng belong to whoever holds wheel_mutex
+    std::chrono::steady_clock::time_point epoch;
+    TimingWheel wheel;
+    std::mutex wheel_mutex;
+    std::mt19937 rng;
+    std::vector<std::pair<std::uint64_t, std::function<void()>>> incoming;
+    std::mutex incoming_mutex;
+
+    // Helper methods
+    void create_world();
+    std::uint64_t tick_at(std::chrono::steady_clock::time_point time) const;
+    void wander(const std::string& npc, Location* location, std::uint64_t period);
+    void grow_hunger();
+
+public:
+    // Constructor; builds the content (the original campus by default) under the given rules
+    explicit World(std::shared_ptr<const RuleBook> rules = RuleBook::standard(),
+                   std::shared_ptr<const WorldTemplate> content = WorldTemplate::standard());
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Location access; neighbor maps are fixed after construction and need no lock
+    std::vector<Location>& get_locations();
+    const std::vector<Location>& get_locations() const;
+    int location_id(const Location* location) const;
+
+    // The content this World was built from, and Locations by its stable ids (names)
+    const WorldTemplate& get_content() const;
+    Location* find_location(const std::string& name);
+
+    // Columnar storage for the Items lying in Locations, and aggregates over it
+    const EntityStore& get_entities() const;
+    long long available_calories() const;
+
+    // Guards a Location's Items and NPCs; Locations are striped over a fixed set of mutexes
+    std::mutex& lock_for(const Location* location) const;
+
+    // Goal tracking; `feed` returns the calories still needed (negative amounts take calories back)
+    int get_calories_needed() const;
+    int feed(int calories);
+    bool is_won() const;
+
+    // Takes over the Elf's progress from the World this one replaces on a reload
+    void continue_from(const World& previous);
+
+    // Progress kept across restarts (the Elf's calories and visited Locations); save_progress
+    // is safe while sessions play, restore_progress must run before any do
+    void save_progress(std::string& out) const;
+    void restore_progress(std::string_view saved, std::chrono::system_clock::duration idle);
+
+    // Full-text index of the World as it was created
+    const SearchIndex& get_search_index() const;
+
+    // Exits as a graph; fixed once the World is built
+    const ExitGraph& get_exit_graph() const;
+
+    // Attribute queries. Whoever adds or removes Items calls `items_changed` while
+    // still holding the Location's lock; `get_item_index` must not be called under one
+    void items_changed(const Location* location);
+    std::shared_ptr<const ItemIndex> get_item_index() const;
+
+    // The rules this World plays by, and their dispatch table
+    const RuleBook& get_rules() const;
+    const RuleBook::Table& get_rule_table() const;
+
+    // The rule for an action on an Item at a Location, or nullptr if none applies
+    const RuleBook::Rule* find_rule(RuleBook::Action action, const Item& item, const Location* location) const;
+
+    // Simulation. `schedule` is safe from any thread and under any lock; events run
+    // inside `advance`, which catches the World up to `now` (a no-op if another
+    // session is already doing so). `item_taken` schedules the Item's respawn
+    void schedule(std::uint64_t delay, std::function<void()> action);
+    void advance(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    void item_taken(Location* origin, const Item& item);
+};
+
+#endif
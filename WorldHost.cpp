@@ -0,0 +1,40 @@
+#include "WorldHost.h"
+
+// Constructor
+WorldHost::WorldHost(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules, bool shared)
+    : version(1) {
+    auto world = std::make_shared<World>(rules, content);
+    current.store(std::make_shared<const Release>(Release{1, std::move(content), std::move(rules), shared ? world : nullptr}));
+}
+
+std::uint64_t WorldHost::get_version() const { return version.load(std::memory_order_acquire); }
+
+std::shared_ptr<const WorldHost::Release> WorldHost::get_release() const { return current.load(); }
+
+std::shared_ptr<World> WorldHost::world_for(const Release& release) {
+    return release.world ? release.world : std::make_shared<World>(release.rules, release.content);
+}
+
+/**
+ * @brief Builds and publishes a release with new content and rules.
+ *
+ * The new World is built before anything is published, so a bad file leaves
+ * the server as it was. A shared World takes over the Elf's progress from the
+ * one it replaces; calories given in the moment between that copy and the
+ * swap count only in the old World. Sessions pick the release up at their
+ * next command (see Game::execute), and the old World lives on until the last
+ * of them does.
+ *
+ * @param content The new content.
+ * @param rules The new rules.
+ */
+void WorldHost::reload(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules) {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    std::shared_ptr<const Release> previous = current.load();
+    auto world = std::make_shared<World>(rules, content);
+    if (previous->world) world->continue_from(*previous->world);
+    std::uint64_t next = previous->version + 1;
+    current.store(std::make_shared<const Release>(
+        Release{next, std::move(content), std::move(rules), previous->world ? std::move(world) : nullptr}));
+    version.store(next, std::memory_order_release);
+}
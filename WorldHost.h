@@ -0,0 +1,49 @@
+#ifndef WORLDHOST_H
+#define WORLDHOST_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "World.h"
+
+// Hands out Worlds to sessions and swaps in new content while they play, RCU
+// style. The current release (content, rules, and the shared World if there is
+// one) is published through one atomic pointer: sessions check its version
+// between commands, a reload builds the next release off to the side and
+// publishes it with one store, and an old release is freed once the last
+// session still using it moves on. Nothing on the command path waits for a
+// reload.
+class WorldHost {
+public:
+    struct Release {
+        std::uint64_t version;
+        std::shared_ptr<const WorldTemplate> content;
+        std::shared_ptr<const RuleBook> rules;
+        std::shared_ptr<World> world;   // the World every session shares, or null for one World each
+    };
+
+private:
+    std::atomic<std::shared_ptr<const Release>> current;
+    std::atomic<std::uint64_t> version;
+    std::mutex reload_mutex;
+
+public:
+    // Constructor; the content and rules are checked by building a World from them
+    WorldHost(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules, bool shared);
+
+    // Cheap check for sessions; changes whenever a new release is published
+    std::uint64_t get_version() const;
+
+    // The current release; it stays valid for as long as the pointer is held
+    std::shared_ptr<const Release> get_release() const;
+
+    // The World a new session should play in under a release
+    static std::shared_ptr<World> world_for(const Release& release);
+
+    // Publishes new content and rules; throws std::invalid_argument (keeping the
+    // current release) if they do not build a World
+    void reload(std::shared_ptr<const WorldTemplate> content, std::shared_ptr<const RuleBook> rules);
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include "WorldTemplate.h"
+#include <charconv>
+#include <optional>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+struct Token {
+    std::string text;
+    bool quoted;
+};
+
+std::invalid_argument content_error(int line, const std::string& message) {
+    return std::invalid_argument("World line " + std::to_string(line) + ": " + message);
+}
+
+// Splits a line into words and quoted strings; ':' and ',' are tokens of their own
+std::vector<Token> tokenize(std::string_view line, int line_number) {
+    std::vector<Token> tokens;
+    std::size_t pos = 0;
+    while (pos < line.size()) {
+        char c = line[pos];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            pos++;
+        } else if (c == '#') {
+            break;
+        } else if (c == ':' || c == ',') {
+            tokens.push_back({std::string(1, c), false});
+            pos++;
+        } else if (c == '"') {
+            std::size_t end = line.find('"', pos + 1);
+            if (end == std::string_view::npos) throw content_error(line_number, "unterminated string.");
+            tokens.push_back({std::string(line.substr(pos + 1, end - pos - 1)), true});
+            pos = end + 1;
+        } else {
+            std::size_t end = line.find_first_of(" \t\r#:,\"", pos);
+            if (end == std::string_view::npos) end = line.size();
+            tokens.push_back({std::string(line.substr(pos, end - pos)), false});
+            pos = end;
+        }
+    }
+    return tokens;
+}
+
+template <typename Number>
+Number parse_number(const Token& token, int line_number) {
+    Number value{};
+    const std::string& text = token.text;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (token.quoted || ec != std::errc() || ptr != text.data() + text.size()) {
+        throw content_error(line_number, "expected a number, not '" + text + "'.");
+    }
+    return value;
+}
+
+// An NPC whose `say` lines or script may still follow
+struct Pending {
+    std::uint32_t location;
+    std::string name;
+    std::string description;
+    std::uint64_t wander_ticks;
+    std::vector<PackedText> messages;
+    std::shared_ptr<const DialogueScript> script;
+    int line;
+};
+
+}
+
+/**
+ * @brief Parses content text into Locations, exits, Items and NPCs.
+ *
+ * Locations must be declared before anything refers to them, and a Location
+ * has at most one exit in each direction. Item and NPC values are checked by
+ * their own constructors, and dialogue scripts are compiled here, so a
+ * template that compiles builds a World without errors.
+ * Once everything is parsed, the text is packed with a dictionary trained on it.
+ *
+ * @param source The content text.
+ * @return The compiled template.
+ */
+WorldTemplate WorldTemplate::compile(std::string_view source) {
+    WorldTemplate content;
+    std::vector<std::string> texts;   // every description, message and scripted line, to train the dictionary on
+    std::optional<Pending> pending;
+    std::set<std::pair<std::uint32_t, std::string>> directions;   // (from, direction) of every exit so far
+    auto finish_npc = [&]() {
+        if (!pending) return;
+        try {
+            NPC npc = pending->script ? NPC(pending->name, pending->description, pending->script)
+                                      : NPC(pending->name, pending->description, pending->messages);
+            content.npcs.push_back({pending->location, std::move(npc), pending->wander_ticks});
+        } catch (const std::invalid_argument& error) {
+            throw content_error(pending->line, error.what());
+        }
+        pending.reset();
+    };
+
+    int line_number = 0;
+    std::size_t pos = 0;
+    while (pos <= source.size()) {
+        std::size_t end = source.find('\n', pos);
+        if (end == std::string_view::npos) end = source.size();
+        std::string_view line = source.substr(pos, end - pos);
+        std::vector<Token> tokens = tokenize(line, ++line_number);
+        pos = end + 1;
+        if (tokens.empty()) continue;
+
+        std::size_t i = 1;
+        auto next = [&](const char* what) -> const Token& {
+            if (i >= tokens.size()) throw content_error(line_number, std::string("expected ") + what + ".");
+            return tokens[i++];
+        };
+        auto expect = [&](const char* word) {
+            const Token& token = next((std::string("'") + word + "'").c_str());
+            if (token.quoted || token.text != word) throw content_error(line_number, std::string("expected '") + word + "'.");
+        };
+        auto quoted = [&](const char* what) -> const std::string& {
+            const Token& token = next(what);
+            if (!token.quoted) throw content_error(line_number, std::string("expected ") + what + " in quotes.");
+            texts.push_back(token.text);
+            return token.text;
+        };
+        auto place = [&]() -> std::uint32_t {
+            const Token& name = next("a Location");
+            auto found = content.place_ids.find(name.text);
+            if (found == content.place_ids.end()) throw content_error(line_number, "no Location named '" + name.text + "'.");
+            return found->second;
+        };
+        auto done = [&]() {
+            if (i != tokens.size()) throw content_error(line_number, "unexpected '" + tokens[i].text + "'.");
+        };
+
+        const std::string& keyword = tokens[0].text;
+        if (keyword == "say" && pending) {
+            // say "TEXT"
+            pending->messages.push_back(quoted("the message"));
+            done();
+            if (pending->script) throw content_error(line_number, "an NPC has say lines or a script, not both.");
+            continue;
+        }
+        if (keyword == "script" && pending) {
+            // script, then raw dialogue lines up to `end script`
+            done();
+            if (!pending->messages.empty() || pending->script) {
+                throw content_error(line_number, "an NPC has say lines or a script, not both.");
+            }
+            int script_line = line_number;
+            std::string script;
+            for (;;) {
+                if (pos > source.size()) throw content_error(script_line, "expected 'end script'.");
+                end = source.find('\n', pos);
+                if (end == std::string_view::npos) end = source.size();
+                line = source.substr(pos, end - pos);
+                pos = end + 1;
+                line_number++;
+                std::size_t first = line.find_first_not_of(" \t");
+                std::size_t last = line.find_last_not_of(" \t\r");
+                if (first != std::string_view::npos && line.substr(first, last + 1 - first) == "end script") break;
+                script.append(line).push_back('\n');
+            }
+            try {
+                pending->script = std::make_shared<const DialogueScript>(DialogueScript::compile(script));
+                for (auto& text : pending->script->get_texts()) texts.push_back(std::move(text));
+            } catch (const std::invalid_argument& error) {
+                throw content_error(script_line, error.what());
+            }
+            continue;
+        }
+        finish_npc();
+
+        if (keyword == "location") {
+            // location NAME : "DESCRIPTION"
+            const std::string& name = next("a name").text;
+            expect(":");
+            const std::string& description = quoted("a description");
+            done();
+            if (description.empty()) throw content_error(line_number, "Description cannot be blank.");
+            auto id = static_cast<std::uint32_t>(content.places.size());
+            if (!content.place_ids.emplace(name, id).second) {
+                throw content_error(line_number, "Location '" + name + "' is declared twice.");
+            }
+            content.places.push_back({name, description});
+        } else if (keyword == "exit") {
+            // exit FROM DIRECTION TO
+            std::uint32_t from = place();
+            std::string direction = next("a direction").text;
+            std::uint32_t to = place();
+            done();
+            if (direction.empty()) throw content_error(line_number, "Direction cannot be blank.");
+            if (!directions.emplace(from, direction).second) {
+                throw content_error(line_number, "Location '" + content.places[from].name + "' already has an exit " +
+                                                     direction + ".");
+            }
+            content.exits.push_back({from, std::move(direction), to});
+        } else if (keyword == "item") {
+            // item NAME at LOCATION : N calories , W lb , "DESCRIPTION"
+            std::string name = next("a name").text;
+            expect("at");
+            std::uint32_t location = place();
+            expect(":");
+            int calories = parse_number<int>(next("calories"), line_number);
+            expect("calories");
+            expect(",");
+            float weight = parse_number<float>(next("a weight"), line_number);
+            expect("lb");
+            expect(",");
+            const std::string& description = quoted("a description");
+            done();
+            try {
+                content.items.push_back({location, Item(name, description, calories, weight)});
+            } catch (const std::invalid_argument& error) {
+                throw content_error(line_number, error.what());
+            }
+        } else if (keyword == "npc") {
+            // npc NAME at LOCATION [wanders TICKS] : "DESCRIPTION"
+            pending.emplace();
+            pending->line = line_number;
+            pending->name = next("a name").text;
+            expect("at");
+            pending->location = place();
+            pending->wander_ticks = 0;
+            if (i < tokens.size() && tokens[i].text == "wanders" && !tokens[i].quoted) {
+                i++;
+                pending->wander_ticks = parse_number<std::uint64_t>(next("ticks"), line_number);
+                if (pending->wander_ticks == 0) throw content_error(line_number, "wander ticks must be positive.");
+            }
+            expect(":");
+            pending->description = quoted("a description");
+            done();
+        } else {
+            throw content_error(line_number, "expected 'location', 'exit', 'item' or 'npc'.");
+        }
+    }
+    finish_npc();
+    content.pack(texts);
+    return content;
+}
+
+std::shared_ptr<const WorldTemplate> WorldTemplate::standard() {
+    static const std::shared_ptr<const WorldTemplate> content = std::make_shared<const WorldTemplate>(compile(R"(
+        location "Padnos Hall": "Lots of science labs are in this building."
+        location "Zumberge Field": "A large open field on campus."
+        location "Kirkhoff Center": "The student union with restaurants and stores."
+        location Woods: "A mysterious forest behind campus."
+
+        exit "Padnos Hall" east "Zumberge Field"
+        exit "Zumberge Field" west "Padnos Hall"
+        exit "Zumberge Field" north "Kirkhoff Center"
+        exit "Kirkhoff Center" south "Zumberge Field"
+        exit "Kirkhoff Center" west Woods
+        exit Woods east "Kirkhoff Center"
+
+        npc Elf at Woods: "A magical creature who can save GVSU."
+        script
+            # var 0: how many times the player has talked to the Elf
+            load 0
+            push 1
+            add
+            dup
+            store 0
+            push 1
+            eq
+            jz returning
+            say "Bring me food! I need "
+            calories
+            saynum
+            say " calories!"
+            end
+        returning:
+            has Cookie
+            jz hungry
+            say "Is that a cookie? Give it to me!"
+            end
+        hungry:
+            calories
+            push 100
+            lt
+            jz far
+            say "You're almost there!"
+            end
+        far:
+            say "I still need "
+            calories
+            saynum
+            say " calories."
+        end script
+        npc Squirrel at "Zumberge Field" wanders 150: "A campus squirrel that never stays in one place."
+        say "Chitter chitter!"
+        say "The squirrel eyes your pockets."
+        say "It darts off and comes right back."
+
+        item Cookie at "Padnos Hall": 10 calories, 0.5 lb, "A delicious M&M cookie."
+        item "Rusty Nail" at "Zumberge Field": 0 calories, 1 lb, "A rusty nail (I hope you've had a tetanus shot)."
+    )"));
+    return content;
+}
+
+/**
+ * @brief Packs all of the template's text with a dictionary trained on it.
+ *
+ * Content repeats its own phrases a lot ("a campus", "building with"), so a
+ * dictionary trained on them shrinks the text well; the dictionary is kept
+ * with the template and shared by everything built from it.
+ *
+ * @param texts Every description, message and scripted line in the template.
+ */
+void WorldTemplate::pack(const std::vector<std::string>& texts) {
+    dictionary = TextDictionary::train(std::vector<std::string_view>(texts.begin(), texts.end()));
+    for (auto& place : places) place.description.pack(dictionary);
+    for (auto& placement : items) placement.item.pack(dictionary);
+    for (auto& character : npcs) character.npc.pack(dictionary);
+}
+
+// Getters
+const std::vector<WorldTemplate::Place>& WorldTemplate::get_places() const { return places; }
+const std::vector<WorldTemplate::Exit>& WorldTemplate::get_exits() const { return exits; }
+const std::vector<WorldTemplate::Placement>& WorldTemplate::get_items() const { return items; }
+const std::vector<WorldTemplate::Character>& WorldTemplate::get_npcs() const { return npcs; }
+const std::shared_ptr<const TextDictionary>& WorldTemplate::get_dictionary() const { return dictionary; }
+
+int WorldTemplate::find_place(const std::string& name) const {
+    auto found = place_ids.find(name);
+    return found == place_ids.end() ? -1 : static_cast<int>(found->second);
+}
+
+const Item* WorldTemplate::find_item(const std::string& name) const {
+    for (const auto& placement : items) {
+        if (placement.item.get_name() == name) return &placement.item;
+    }
+    return nullptr;
+}
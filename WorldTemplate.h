@@ -0,0 +1,85 @@
+#ifndef WORLDTEMPLATE_H
+#define WORLDTEMPLATE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Item.h"
+#include "NPC.h"
+#include "PackedText.h"
+
+// The content a World is built from: Locations, exits, Items and NPCs. A
+// template is immutable once compiled, so Worlds built from it (and a server
+// reloading it) can share it freely. Content text looks like
+//   location "Padnos Hall": "Lots of science labs are in this building."
+//   exit "Padnos Hall" east "Zumberge Field"
+//   item Cookie at "Padnos Hall": 10 calories, 0.5 lb, "A delicious M&M cookie."
+//   npc Squirrel at "Zumberge Field" wanders 150: "A campus squirrel."
+//   say "Chitter chitter!"
+//   npc Elf at Woods: "A magical creature who can save GVSU."
+//   script
+//       say "Bring me food!"
+//   end script
+// An NPC speaks its `say` lines in turn, or runs the dialogue script between
+// `script` and `end script`; `wanders N` moves it every N ticks. Names are
+// quoted if they contain spaces. Location and Item names are the stable ids
+// sessions are matched up by when content is reloaded. Descriptions and `say`
+// lines are packed with a dictionary trained on this content's own text.
+class WorldTemplate {
+public:
+    struct Place {
+        std::string name;
+        PackedText description;
+    };
+
+    struct Exit {
+        std::uint32_t from;
+        std::string direction;
+        std::uint32_t to;
+    };
+
+    struct Placement {
+        std::uint32_t location;
+        Item item;
+    };
+
+    struct Character {
+        std::uint32_t location;
+        NPC npc;
+        std::uint64_t wander_ticks;  // 0 if the NPC stays put
+    };
+
+private:
+    std::vector<Place> places;
+    std::vector<Exit> exits;
+    std::vector<Placement> items;
+    std::vector<Character> npcs;
+    std::unordered_map<std::string, std::uint32_t> place_ids;
+    std::shared_ptr<const TextDictionary> dictionary;
+
+    // Helper methods
+    void pack(const std::vector<std::string>& texts);
+
+public:
+    // Parses content text; throws std::invalid_argument naming the bad line
+    static WorldTemplate compile(std::string_view source);
+
+    // The campus of the original game, compiled once
+    static std::shared_ptr<const WorldTemplate> standard();
+
+    // Getters; a Location's id is its index in `get_places`
+    const std::vector<Place>& get_places() const;
+    const std::vector<Exit>& get_exits() const;
+    const std::vector<Placement>& get_items() const;
+    const std::vector<Character>& get_npcs() const;
+    const std::shared_ptr<const TextDictionary>& get_dictionary() const;
+
+    // Lookup by stable id; -1 or nullptr if absent
+    int find_place(const std::string& name) const;
+    const Item* find_item(const std::string& name) const;
+};
+
+#endif
@@ -1,7 +1,217 @@
+#include "Console.h"
+#include "Server.h"
+#include "Simulator.h"
+#include "Validator.h"
 #include "Game.h"
+#include <pthread.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
 
-int main() {
-    Game game;
-    game.play();
+namespace {
+    // Compiles a content or rules file; errors are prefixed with the file's name
+    template <typename Compiled>
+    std::shared_ptr<const Compiled> compile_file(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) throw std::invalid_argument("Cannot open " + path);
+        std::ostringstream text;
+        text << file.rdbuf();
+        try {
+            return std::make_shared<const Compiled>(Compiled::compile(text.str()));
+        } catch (const std::invalid_argument& error) {
+            throw std::invalid_argument(path + ": " + error.what());
+        }
+    }
+
+    constexpr const char* USAGE =
+        "Usage: untitled [--world FILE] [--rules FILE]           play on the console\n"
+        "       untitled --serve PORT [--reactors N] [--workers N] [--shared] [--bind ADDRESS] [--backend epoll|uring]\n"
+        "                             [--world FILE] [--rules FILE] [--hibernate SECONDS] [--hibernate-dir DIR]\n"
+        "                             [--journal DIR] [--commit-us N] [--autosave SECONDS]\n"
+        "                             [--autosave-rate MB_PER_SECOND] [--session-ttl SECONDS]\n"
+        "       untitled --simulate AGENTS [--steps N] [--greedy] [--threads N] [--world FILE] [--rules FILE]\n"
+        "       untitled --validate [--threads N] [--world FILE] [--rules FILE]   exits 1 if some players cannot win\n";
+
+    // A whole command-line argument as a number in [min, max]; throws std::invalid_argument otherwise
+    template <typename Number>
+    Number parse_number(const std::string& flag, const std::string& text, Number min, Number max) {
+        Number value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size() || value < min || value > max) {
+            throw std::invalid_argument("Invalid " + flag + ": " + text);
+        }
+        return value;
+    }
+
+    // Loads the files named on the command line (the built-in ones where none is
+    // named) and checks that they build a World together
+    void load(const std::string& world_path, const std::string& rules_path, Server::Options& options) {
+        auto content = world_path.empty() ? WorldTemplate::standard() : compile_file<WorldTemplate>(world_path);
+        auto rules = rules_path.empty() ? RuleBook::standard() : compile_file<RuleBook>(rules_path);
+        try {
+            World check(rules, content);
+        } catch (const std::invalid_argument& error) {
+            throw std::invalid_argument((rules_path.empty() ? "rules" : rules_path) + ": " + error.what());
+        }
+        options.content = std::move(content);
+        options.rules = std::move(rules);
+    }
+}
+
+// Runs the console game, the line server, the simulator or the validator; see USAGE.
+// A server reloads its world and rules files on SIGHUP without dropping anyone.
+int main(int argc, char* argv[]) {
+    bool serve = false;
+    bool simulate = false;
+    bool validate = false;
+    int steps = 100;
+    std::string world_path;
+    std::string rules_path;
+    Server::Options options;
+    Simulator::Options simulation;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            // The argument after a flag that takes one
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            auto number = [&]<typename Number>(Number min, Number max = std::numeric_limits<Number>::max()) {
+                return parse_number(arg, value(), min, max);
+            };
+            if (arg == "--serve") serve = true;
+            else if (arg == "--reactors") options.reactors = number(1, 1024);
+            else if (arg == "--workers") options.workers = number(0, 1024);
+            else if (arg == "--shared") options.shared_world = true;
+            else if (arg == "--bind") options.address = value();
+            else if (arg == "--hibernate") options.hibernate_after = std::chrono::seconds(number(0));
+            else if (arg == "--hibernate-dir") options.hibernate_directory = value();
+            else if (arg == "--journal") options.journal_directory = value();
+            else if (arg == "--commit-us") options.commit_interval = std::chrono::microseconds(number(0));
+            else if (arg == "--autosave") options.autosave_interval = std::chrono::seconds(number(0));
+            else if (arg == "--autosave-rate") options.autosave_rate = number(std::uint64_t{0}, UINT64_MAX >> 20) << 20;
+            else if (arg == "--session-ttl") options.session_ttl = std::chrono::seconds(number(0));
+            else if (arg == "--backend") {
+                std::string backend = value();
+                if (backend == "uring") options.backend = Server::Backend::IO_URING;
+                else if (backend == "epoll") options.backend = Server::Backend::EPOLL;
+                else throw std::invalid_argument("Unknown backend: " + backend);
+            }
+            else if (arg == "--simulate") {
+                simulate = true;
+                simulation.agents = number(std::size_t{1});
+            }
+            else if (arg == "--validate") validate = true;
+            else if (arg == "--steps") steps = number(0);
+            else if (arg == "--greedy") simulation.policy = Simulator::Policy::GREEDY;
+            else if (arg == "--threads") simulation.threads = number(0u, 4096u);
+            else if (arg == "--world") world_path = value();
+            else if (arg == "--rules") rules_path = value();
+            else if (!arg.starts_with("-")) options.port = parse_number<std::uint16_t>("port", arg, 1, 65535);
+            else throw std::invalid_argument("Unknown option: " + arg);
+        }
+    } catch (const std::invalid_argument& error) {
+        std::cerr << error.what() << "\n" << USAGE;
+        return 1;
+    }
+    try {
+        load(world_path, rules_path, options);
+    } catch (const std::invalid_argument& error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+
+    if (validate) {
+        World world(options.rules, options.content);
+        Validator::Report report = Validator::validate(world, Game::MAX_WEIGHT, simulation.threads);
+        const auto& locations = world.get_locations();
+        auto list = [&](const char* heading, std::size_t count, auto&& line) {
+            std::cout << heading << ":" << (count ? "" : " None") << "\n";
+            for (std::size_t i = 0; i < count && i < 10; i++) std::cout << "- " << line(i) << "\n";
+            if (count > 10) std::cout << "- ... and " << count - 10 << " more\n";
+        };
+        auto name = [&](std::uint32_t location) { return locations[location].get_name(); };
+        auto food = [&](const Validator::Food& item) {
+            return item.name + " (" + std::to_string(item.calories) + " calories) in " + name(item.location);
+        };
+
+        std::cout << "Validated " << locations.size() << " Locations with " << world.get_exit_graph().get_targets().size()
+                  << " exits\n";
+        list("Where the Elf is fed", report.feeding.size(), [&](std::size_t i) { return name(report.feeding[i]); });
+        list("Unreachable from there", report.unreachable.size(), [&](std::size_t i) { return name(report.unreachable[i]); });
+        list("No way back to it", report.stranded.size(), [&](std::size_t i) { return name(report.stranded[i]); });
+        list("Dead ends", report.dead_ends.size(), [&](std::size_t i) { return name(report.dead_ends[i]); });
+        list("One-way exits", report.one_way.size(),
+             [&](std::size_t i) { return name(report.one_way[i].first) + " -> " + name(report.one_way[i].second); });
+        list("Food that cannot be delivered", report.unreachable_food.size(),
+             [&](std::size_t i) { return food(report.unreachable_food[i]); });
+        list("Food over the carry limit", report.heavy_food.size(), [&](std::size_t i) { return food(report.heavy_food[i]); });
+        std::cout << "Calorie goal: " << report.deliverable_calories << " deliverable of " << report.calories_needed
+                  << " needed, " << (report.goal_achievable ? "achievable" : "not achievable") << "\n";
+        return report.has_errors() ? 1 : 0;
+    }
+
+    if (simulate) {
+        World world(options.rules, options.content);
+        Simulator simulator(world, simulation);
+        auto started = std::chrono::steady_clock::now();
+        simulator.run(steps);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        double agent_steps = static_cast<double>(simulation.agents) * steps;
+        std::cout << "Simulated " << simulation.agents << " agents for " << steps << " steps in " << seconds << " s ("
+                  << agent_steps / seconds / 1e6 << " million agent-steps/s)\n";
+        std::cout << "Calories eaten: " << simulator.total_eaten() << " of " << world.available_calories() << "\n";
+
+        // Heatmap, busiest Locations first
+        const auto& visits = simulator.get_visits();
+        std::vector<std::size_t> order(visits.size());
+        for (std::size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::size_t shown = std::min<std::size_t>(order.size(), 10);
+        std::partial_sort(order.begin(), order.begin() + shown, order.end(),
+                          [&visits](std::size_t a, std::size_t b) { return visits[a] > visits[b]; });
+        std::cout << "Visits by Location:\n";
+        for (std::size_t i = 0; i < shown; i++) {
+            std::cout << "- " << world.get_locations()[order[i]].get_name() << ": " << visits[order[i]] << " ("
+                      << 100.0 * static_cast<double>(visits[order[i]]) / agent_steps << "%)\n";
+        }
+        return 0;
+    }
+
+    if (serve) {
+        // SIGHUP is blocked in every thread (reactors inherit the mask) and taken by one with sigwait
+        sigset_t hangup;
+        sigemptyset(&hangup);
+        sigaddset(&hangup, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &hangup, nullptr);
+        Server server(options);
+        std::thread reloader([&server, &hangup, world_path, rules_path] {
+            int signal = 0;
+            while (sigwait(&hangup, &signal) == 0) {
+                try {
+                    Server::Options fresh;
+                    load(world_path, rules_path, fresh);
+                    server.reload(fresh.content, fresh.rules);
+                    std::cerr << "Reloaded world and rules\n";
+                } catch (const std::invalid_argument& error) {
+                    std::cerr << "Reload failed, keeping the current world: " << error.what() << "\n";
+                }
+            }
+        });
+        reloader.detach();
+        std::cerr << "Serving GVZork on " << options.address << ":" << options.port << "\n";
+        server.run();
+        return 0;
+    }
+
+    Console console(std::make_shared<World>(options.rules, options.content));
+    console.play();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,34 @@
+/**
+ * @file console_undo_go.cpp
+ * @brief Checks that undoing a move in the console forgets the visited mark.
+ *
+ * The console plays in a World of its own, so `go` followed by `undo` must
+ * leave the Location the player left unvisited again.
+ */
+
+#include "Console.h"
+#include <iostream>
+#include <sstream>
+
+int main() {
+    auto world = std::make_shared<World>();
+    std::istringstream input("go north\nundo\ngo south\nundo\ngo east\nundo\ngo west\nundo\n");
+    std::ostringstream output;
+    std::streambuf* old_in = std::cin.rdbuf(input.rdbuf());
+    std::streambuf* old_out = std::cout.rdbuf(output.rdbuf());
+    Console(world).play();
+    std::cin.rdbuf(old_in);
+    std::cout.rdbuf(old_out);
+
+    if (output.str().find("You moved") == std::string::npos) {
+        std::cerr << "The player never moved.\n";
+        return 1;
+    }
+    for (const auto& location : world->get_locations()) {
+        if (location.get_visited()) {
+            std::cerr << location.get_name() << " is still visited after undo.\n";
+            return 1;
+        }
+    }
+    return 0;
+}